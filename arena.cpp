@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "profile.cpp"
+using namespace std;
+
+///////////////////////////////////////////////////
+///// RUN ARENA ///////////////////////////////////
+///////////////////////////////////////////////////
+
+// bump allocator for everything a simulation run needs.  nothing is freed on its own:
+// reset() hands the whole arena back at once and keeps the blocks for the next run,
+// so after the first run on a thread there is no allocator traffic at all
+class Arena {
+    private:
+        static const size_t ALIGN = 64; // cache line, so every column starts on its own line
+        static const size_t BLOCKSIZE = 1 << 20; // minimum block size in bytes
+        vector<char *> BLOCKS; // every block allocated so far
+        vector<size_t> SIZES; // size of each block
+        size_t CURRENT; // block currently being carved up
+        size_t OFFSET; // bytes used in the current block
+
+        static size_t round_up(size_t bytes) { return (bytes + ALIGN - 1) / ALIGN * ALIGN; }
+
+    public:
+        Arena() : CURRENT(0), OFFSET(0) {};
+        ~Arena() { for (int i = 0; i < BLOCKS.size(); i++) free(BLOCKS[i]); }
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        // uninitialized space for count values of type T
+        template <class T> T * alloc(size_t count) {
+            size_t bytes = round_up(count * sizeof(T));
+            // skip blocks left over from earlier runs that are too small for this request
+            while (CURRENT < BLOCKS.size() && OFFSET + bytes > SIZES[CURRENT]) { CURRENT++; OFFSET = 0; }
+            if (CURRENT == BLOCKS.size()) {
+                size_t size = bytes > BLOCKSIZE ? bytes : BLOCKSIZE;
+                char * block = static_cast<char *>(aligned_alloc(ALIGN, size));
+                if (block == nullptr) throw bad_alloc();
+                PROFILE_ALLOCATION();
+                BLOCKS.push_back(block);
+                SIZES.push_back(size);
+                OFFSET = 0;
+            }
+            T * out = reinterpret_cast<T *>(BLOCKS[CURRENT] + OFFSET);
+            OFFSET += bytes;
+            return out;
+        }
+
+        // space for count values of type T, all set to value
+        template <class T> T * fill(size_t count, T value) {
+            T * out = alloc<T>(count);
+            for (size_t i = 0; i < count; i++) out[i] = value;
+            return out;
+        }
+
+        // space for count values of type T holding the first old_count values of old.
+        // the old space is not given back until the next reset, so growing by doubling
+        // costs at most twice the final size
+        template <class T> T * grow(const T * old, size_t old_count, size_t count) {
+            T * out = alloc<T>(count);
+            for (size_t i = 0; i < old_count; i++) out[i] = old[i];
+            return out;
+        }
+
+        // release everything allocated since the last reset, keeping the memory for reuse
+        void reset() { CURRENT = 0; OFFSET = 0; }
+};
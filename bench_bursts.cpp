@@ -0,0 +1,140 @@
+// microbenchmark: heap allocations and time per simulated quantum when consuming bursts.
+// compares the old PCB pattern (vector getters returning copies, erase(begin()), setter to write
+// the copy back) against the burst cursors of ProcessTable.
+// build and run: g++ -O2 bench_bursts.cpp -o bench_bursts && ./bench_bursts [processes]
+#include "pcb.cpp"
+#include "rng.cpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#define QUANTUM 40 // RRTIME used by the simulation
+#define BURSTMIN 1
+#define BURSTMAX 8
+#define CPUMIN 30
+#define CPUMAX 60
+#define IOMIN 5
+#define IOMAX 10
+
+///// ALLOCATION COUNTING /////
+
+static long long allocations = 0;
+
+void * operator new(size_t size) {
+    allocations++;
+    void * p = malloc(size ? size : 1);
+    if (p == nullptr) throw bad_alloc();
+    return p;
+}
+void operator delete(void * p) noexcept { free(p); }
+void operator delete(void * p, size_t) noexcept { free(p); }
+
+///// OLD PATTERN /////
+
+// the burst handling of the original PCB class
+class LegacyPCB {
+    private:
+        vector<int> IO_TIME;
+        vector<int> CPU_TIME;
+    public:
+        LegacyPCB(vector<int> io, vector<int> cpu) : IO_TIME(io), CPU_TIME(cpu) {};
+        vector<int> getIO_TIME() { return IO_TIME; }
+        vector<int> getCPU_TIME() { return CPU_TIME; }
+        void setIO_TIME(vector<int> iot) { IO_TIME = iot; }
+        void setCPU_TIME(vector<int> cpt) { CPU_TIME = cpt; }
+};
+
+// one round-robin quantum the way the old scheduler loop did it. returns false once finished
+bool legacy_quantum(LegacyPCB& pcb) {
+    vector<int> cputimes = pcb.getCPU_TIME();
+    if (cputimes.empty()) return false;
+    int time = cputimes[0] - QUANTUM;
+    if (time <= 0) {
+        cputimes.erase(cputimes.begin());
+        pcb.setCPU_TIME(cputimes);
+        // burst done: the io burst after it is handled the same way
+        vector<int> iotimes = pcb.getIO_TIME();
+        if (!iotimes.empty()) {
+            iotimes.erase(iotimes.begin());
+            pcb.setIO_TIME(iotimes);
+        }
+    } else {
+        cputimes[0] = time;
+        pcb.setCPU_TIME(cputimes);
+    }
+    return true;
+}
+
+///// CURSORS /////
+
+bool cursor_quantum(ProcessTable& procs, int i) {
+    if (!procs.has_cpu(i)) return false;
+    int time = procs.CPU_LEFT[i] - QUANTUM;
+    if (time <= 0) {
+        procs.next_cpu(i);
+        if (procs.has_io(i)) procs.next_io(i);
+    } else {
+        procs.CPU_LEFT[i] = time;
+    }
+    return true;
+}
+
+int main(int argc, char * argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 100000;
+    if (n < 1) { fprintf(stderr, "Process count must be at least 1.\n"); return 1; }
+
+    // same random workload for both patterns
+    Rng rng(12345);
+    vector<vector<int>> cpu(n), io(n);
+    long long total_bursts = 0;
+    for (int i = 0; i < n; i++) {
+        int bursts = rng.below(BURSTMAX - BURSTMIN) + BURSTMIN;
+        for (int j = 0; j < bursts; j++) {
+            if (j % 2) io[i].push_back(rng.below(IOMAX - IOMIN) + IOMIN);
+            else cpu[i].push_back(rng.below(CPUMAX - CPUMIN) + CPUMIN);
+        }
+        total_bursts += bursts;
+    }
+
+    vector<LegacyPCB> legacy;
+    for (int i = 0; i < n; i++) legacy.push_back(LegacyPCB(io[i], cpu[i]));
+
+    Arena arena;
+    ProcessTable procs;
+    ProcessTable::WorkloadColumns layout = procs.allocate(arena, n, total_bursts);
+    int offset = 0;
+    for (int i = 0; i < n; i++) {
+        layout.pid[i] = i;
+        layout.priority[i] = 1;
+        layout.cpu_begin[i] = layout.cpu_end[i] = offset;
+        for (int j = 0; j < cpu[i].size(); j++) layout.bursts[layout.cpu_end[i]++] = cpu[i][j];
+        layout.io_begin[i] = layout.io_end[i] = layout.cpu_end[i];
+        for (int j = 0; j < io[i].size(); j++) layout.bursts[layout.io_end[i]++] = io[i][j];
+        offset = layout.io_end[i];
+    }
+    procs.rewind();
+
+    // round robin over every process until all bursts are consumed
+    auto measure = [&](const char * name, auto quantum) {
+        long long quanta = 0;
+        long long before = allocations;
+        auto start = chrono::steady_clock::now();
+        bool any = true;
+        while (any) {
+            any = false;
+            for (int i = 0; i < n; i++) {
+                if (quantum(i)) { quanta++; any = true; }
+            }
+        }
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        long long allocs = allocations - before;
+        printf("%-12s %12lld %14lld %16.3f %12.1f\n", name, quanta, allocs,
+               static_cast<double>(allocs) / quanta, ns / quanta);
+    };
+
+    printf("%-12s %12s %14s %16s %12s\n", "pattern", "quanta", "allocations", "allocs/quantum", "ns/quantum");
+    measure("vector-copy", [&](int i) { return legacy_quantum(legacy[i]); });
+    measure("cursor", [&](int i) { return cursor_quantum(procs, i); });
+    return 0;
+}
@@ -0,0 +1,176 @@
+// benchmark of the simulator itself: how fast workloads are generated and how fast each engine
+// works through them, over process count, core count and bursts per process.  every case runs
+// in a child process so its peak RSS is its own.  prints csv, one line per case:
+//  - gen_ns_per_process  time gen_workload takes per process
+//  - events              arrivals, dispatches, quantum ends and io completions simulated
+//  - events_per_s        events over the engine's run time
+//  - ns_per_dispatch     engine run time over the quanta handed to a core
+//  - peak_rss_kb         most memory the case had resident
+// the sweep varies one axis at a time around 1e5 processes, 16 cores and 8 bursts.  its
+// workloads keep every core busy, so the tick engine has no idle passes for the event engine
+// to skip and the event engine comes out slower by what its event queue costs; it wins with
+// many cores or sparse arrivals.
+// build and run: g++ -O2 bench_sim.cpp -o bench_sim && ./bench_sim [options] > bench.csv
+//  --engine=tick|event     only run this engine (default both)
+//  --max-processes=N       skip cases with more processes than this (default 10000000)
+//  --baseline=FILE         compare events_per_s with an earlier csv (bench_baseline.csv is
+//                          committed) and fail if any case is more than --tolerance slower
+//  --tolerance=PCT         slowdown allowed against the baseline, in percent (default 20)
+#include "pcb.cpp"
+#include "rng.cpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <tuple>
+#include <unistd.h>
+
+#include "tick_engine.cpp"
+#include "event_engine.cpp"
+#include "workload.cpp"
+
+///// ONE CASE /////
+
+struct BenchCase {
+    string engine;
+    int processes;
+    int cores;
+    int bursts;
+};
+
+// what the child sends back to the parent
+struct BenchTimes {
+    double gen_ns = 0; // whole workload generation
+    double run_ns = 0; // engine only
+    long long events = 0;
+    long long dispatches = 0;
+};
+
+// generate the workload of one case and simulate it once
+BenchTimes run_case(const BenchCase& c) {
+    SimConfig config;
+    config.cores = c.cores;
+    config.procmin = c.processes;
+    config.procmax = c.processes + 1; // exactly this many
+    config.burstmin = c.bursts;
+    config.burstmax = c.bursts + 1;
+
+    BenchTimes times;
+    Arena arena;
+    Rng rng(12345, 0);
+    ProcessTable procs;
+    auto start = chrono::steady_clock::now();
+    gen_workload(procs, arena, rng, config);
+    auto generated = chrono::steady_clock::now();
+    SimCounters counters;
+    if (c.engine == "tick") run_tick_sim(procs, config, arena, counters);
+    else run_event_sim(procs, PolicyConfig(), IoConfig(), config, arena, counters);
+    auto done = chrono::steady_clock::now();
+
+    times.gen_ns = chrono::duration<double, nano>(generated - start).count();
+    times.run_ns = chrono::duration<double, nano>(done - generated).count();
+    long long io_bursts = 0;
+    for (int i = 0; i < procs.count; i++) io_bursts += procs.IO_END[i] - procs.IO_BEGIN[i];
+    // every dispatch ends in a quantum end, every process arrives once
+    times.events = procs.count + 2 * counters.dispatches + io_bursts;
+    times.dispatches = counters.dispatches;
+    return times;
+}
+
+// run the case in a child process; false if the child failed
+bool fork_case(const BenchCase& c, BenchTimes& times, long& peak_rss_kb) {
+    int fds[2];
+    if (pipe(fds) != 0) { cerr << "Error creating pipe.\n"; return false; }
+    pid_t child = fork();
+    if (child < 0) { cerr << "Error forking.\n"; return false; }
+    if (child == 0) {
+        close(fds[0]);
+        BenchTimes result = run_case(c);
+        ssize_t written = write(fds[1], &result, sizeof(result));
+        _exit(written == sizeof(result) ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t got = read(fds[0], &times, sizeof(times));
+    close(fds[0]);
+    int status;
+    struct rusage usage;
+    if (wait4(child, &status, 0, &usage) < 0) { cerr << "Error waiting for case.\n"; return false; }
+    peak_rss_kb = usage.ru_maxrss;
+    return got == sizeof(times) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+///// BASELINE /////
+
+// events_per_s of every case in an earlier csv, keyed by (engine, processes, cores, bursts)
+bool load_baseline(const string& path, map<tuple<string, int, int, int>, double>& baseline) {
+    ifstream in(path);
+    if (!in.is_open()) { cerr << "Error opening baseline file " << path << ".\n"; return false; }
+    string line;
+    getline(in, line); // header
+    while (getline(in, line)) {
+        stringstream fields(line);
+        string engine, value;
+        vector<double> numbers;
+        getline(fields, engine, ',');
+        while (getline(fields, value, ',')) numbers.push_back(atof(value.c_str()));
+        if (numbers.size() < 10) continue;
+        baseline[make_tuple(engine, static_cast<int>(numbers[0]), static_cast<int>(numbers[1]), static_cast<int>(numbers[2]))] = numbers[7];
+    }
+    return true;
+}
+
+int main(int argc, char * argv[]) {
+    string only_engine, baseline_path;
+    int max_processes = 10000000;
+    double tolerance = 20;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--engine=", 9) == 0) only_engine = argv[i] + 9;
+        else if (strncmp(argv[i], "--max-processes=", 16) == 0) max_processes = atoi(argv[i] + 16);
+        else if (strncmp(argv[i], "--baseline=", 11) == 0) baseline_path = argv[i] + 11;
+        else if (strncmp(argv[i], "--tolerance=", 12) == 0) tolerance = atof(argv[i] + 12);
+        else { cerr << "Unknown argument: " << argv[i] << endl; return 1; }
+    }
+    map<tuple<string, int, int, int>, double> baseline;
+    if (!baseline_path.empty() && !load_baseline(baseline_path, baseline)) return 1;
+
+    // one axis at a time around the middle case
+    vector<BenchCase> cases;
+    const char * engines[2] = {"tick", "event"};
+    for (int e = 0; e < 2; e++) {
+        if (!only_engine.empty() && only_engine != engines[e]) continue;
+        for (int n = 100; n <= 10000000; n *= 10) cases.push_back({engines[e], n, 16, 8});
+        const int cores[4] = {4, 64, 128, 512};
+        for (int c = 0; c < 4; c++) cases.push_back({engines[e], 100000, cores[c], 8});
+        const int bursts[3] = {2, 4, 32};
+        for (int b = 0; b < 3; b++) cases.push_back({engines[e], 100000, 16, bursts[b]});
+    }
+
+    printf("engine,processes,cores,bursts,events,dispatches,gen_ns_per_process,run_s,events_per_s,ns_per_dispatch,peak_rss_kb\n");
+    int slower = 0;
+    for (int i = 0; i < cases.size(); i++) {
+        const BenchCase& c = cases[i];
+        if (c.processes > max_processes) continue;
+        BenchTimes times;
+        long rss = 0;
+        if (!fork_case(c, times, rss)) { cerr << "Case " << c.engine << " " << c.processes << " " << c.cores << " " << c.bursts << " failed.\n"; return 1; }
+        double events_per_s = times.events / (times.run_ns / 1e9);
+        printf("%s,%d,%d,%d,%lld,%lld,%.1f,%.4f,%.0f,%.1f,%ld\n", c.engine.c_str(), c.processes, c.cores, c.bursts,
+               times.events, times.dispatches, times.gen_ns / c.processes, times.run_ns / 1e9, events_per_s,
+               times.run_ns / (times.dispatches > 0 ? times.dispatches : 1), rss);
+        fflush(stdout);
+        map<tuple<string, int, int, int>, double>::iterator before = baseline.find(make_tuple(c.engine, c.processes, c.cores, c.bursts));
+        if (before != baseline.end() && events_per_s < before->second * (1 - tolerance / 100)) {
+            fprintf(stderr, "%s %d processes %d cores %d bursts: %.0f events/s, baseline %.0f (%.0f%% slower)\n",
+                    c.engine.c_str(), c.processes, c.cores, c.bursts, events_per_s, before->second,
+                    100 * (1 - events_per_s / before->second));
+            slower++;
+        }
+    }
+    if (slower > 0) { fprintf(stderr, "%d cases slower than the baseline.\n", slower); return 1; }
+    return 0;
+}
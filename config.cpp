@@ -0,0 +1,183 @@
+#pragma once
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+using namespace std;
+
+// constants that stay fixed at build time, define them before including to change them
+#ifndef MLFQLEVELS
+#define MLFQLEVELS 3 // number of levels of the mlfq policy
+#endif
+#ifndef MLFQALLOT
+#define MLFQALLOT 2 // quanta a process gets on an mlfq level before it drops a level
+#endif
+#ifndef MLFQBOOST
+#define MLFQBOOST 1000 // ms between mlfq priority boosts
+#endif
+#ifndef IOTRACKS
+#define IOTRACKS 1000 // tracks an io device's elevator sweeps over
+#endif
+
+///////////////////////////////////////////////////
+///// SIMULATION CONFIGURATION ////////////////////
+///////////////////////////////////////////////////
+
+// tuning parameters of a campaign: mostly mins and maxes.  set from a config file and the
+// command line at startup and then handed to everything that needs them, read-only
+struct SimConfig {
+    int cores = 16; // cores in the simulated cpu
+    int rrtime = 40; // round robin quantum in ms, must be less than cpumax for RR to be effective and not default to pure FCFS
+    int procmin = 50; // min number of processes per sim
+    int procmax = 100; // max number of processes per sim
+    int pidmin = 30; // min pid value
+    int burstmin = 1; // min number of bursts per process
+    int burstmax = 8; // max number of bursts per process
+    int cpumin = 30; // min cpu_burst size in ms
+    int cpumax = 60; // max cpu_burst size in ms
+    int iomin = 5; // min io_burst size in ms
+    int iomax = 10; // max io_burst size in ms
+    int runs = 100; // number of times to run the simulation
+    int switchcost = 0; // ms of a quantum lost when a core switches to a different process
+    int migrationcost = 0; // ms more lost when that process last ran on another core (cold cache)
+    int affinity = 0; // 1 to put dispatched processes back on the core they last ran on where possible (event engine)
+
+    // reserved core amounts out of cores: half for high priority processes, a third for medium
+    // and the rest for low
+    static int high_reserved(int cores) { return cores / 2; }
+    static int medium_reserved(int cores) { return cores / 3; }
+
+    // every parameter and its name, in the order they are written out
+    static const int PARAMETERS = 15;
+    static const char * parameter_name(int f) {
+        static const char * names[PARAMETERS] = {"cores", "rrtime", "procmin", "procmax", "pidmin", "burstmin", "burstmax",
+                                                 "cpumin", "cpumax", "iomin", "iomax", "runs", "switchcost", "migrationcost", "affinity"};
+        return names[f];
+    }
+    int * parameter(int f) {
+        int * fields[PARAMETERS] = {&cores, &rrtime, &procmin, &procmax, &pidmin, &burstmin, &burstmax,
+                                    &cpumin, &cpumax, &iomin, &iomax, &runs, &switchcost, &migrationcost, &affinity};
+        return fields[f];
+    }
+
+    // set the parameter called key from its text value.  false if there is no such parameter
+    // or the value is not a number that fits an int.  the minimum of each is up to valid()
+    bool set(const string& key, const string& value) {
+        for (int f = 0; f < PARAMETERS; f++) {
+            if (key != parameter_name(f)) continue;
+            char * end;
+            errno = 0;
+            long long v = strtoll(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0') { cerr << "Invalid value for " << key << ": " << value << endl; return false; }
+            if (errno == ERANGE || v < INT_MIN || v > INT_MAX) { cerr << "Value for " << key << " is out of range: " << value << endl; return false; }
+            *parameter(f) = static_cast<int>(v);
+            return true;
+        }
+        cerr << "Unknown parameter: " << key << endl;
+        return false;
+    }
+
+    // every parameter as a "key = value" line, which load() reads back
+    void write(ostream& out) const {
+        SimConfig copy = *this;
+        for (int f = 0; f < PARAMETERS; f++) out << parameter_name(f) << " = " << *copy.parameter(f) << "\n";
+    }
+
+    // read "key = value" lines, with # starting a comment
+    bool load(const string& path) {
+        ifstream in(path);
+        if (!in.is_open()) { cerr << "Error opening config file " << path << ".\n"; return false; }
+        return read(in);
+    }
+
+    // the same from any stream
+    bool read(istream& in) {
+        string line;
+        int lineno = 0;
+        while (getline(in, line)) {
+            lineno++;
+            size_t hash = line.find('#');
+            if (hash != string::npos) line.erase(hash);
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == string::npos) continue; // blank line
+            size_t eq = line.find('=');
+            if (eq == string::npos) { cerr << "Missing = on config line " << lineno << ".\n"; return false; }
+            string key = line.substr(first, eq - first);
+            string value = line.substr(eq + 1);
+            key.erase(key.find_last_not_of(" \t\r") + 1);
+            value.erase(0, value.find_first_not_of(" \t\r"));
+            value.erase(value.find_last_not_of(" \t\r") + 1);
+            if (!set(key, value)) { cerr << "On config line " << lineno << ".\n"; return false; }
+        }
+        return true;
+    }
+
+    // whether the parameters make sense together
+    bool valid() const {
+        if (cores < 1) { cerr << "cores must be at least 1.\n"; return false; }
+        if (rrtime < 1) { cerr << "rrtime must be at least 1.\n"; return false; }
+        if (procmin < 1 || procmax < procmin) { cerr << "Need 1 <= procmin <= procmax.\n"; return false; }
+        if (burstmin < 1 || burstmax < burstmin) { cerr << "Need 1 <= burstmin <= burstmax.\n"; return false; }
+        // every burst takes some time, as the workload loaders require
+        if (cpumin < 1 || cpumax < cpumin) { cerr << "Need 1 <= cpumin <= cpumax.\n"; return false; }
+        if (iomin < 1 || iomax < iomin) { cerr << "Need 1 <= iomin <= iomax.\n"; return false; }
+        if (runs < 1) { cerr << "runs must be at least 1.\n"; return false; }
+        if (switchcost < 0 || migrationcost < 0) { cerr << "switchcost and migrationcost cannot be negative.\n"; return false; }
+        // a quantum has to leave some time to make progress in
+        if (switchcost + migrationcost >= rrtime) { cerr << "switchcost + migrationcost must be less than rrtime.\n"; return false; }
+        if (affinity != 0 && affinity != 1) { cerr << "affinity must be 0 or 1.\n"; return false; }
+        return true;
+    }
+};
+
+///////////////////////////////////////////////////
+///// CORE COUNT SPECIALIZATION ///////////////////
+///////////////////////////////////////////////////
+
+// the engines are templates on the core count.  for the common counts it is a compile-time
+// constant, so the per-core arrays sit on the stack and the per-core loops have fixed bounds;
+// CORES = 0 is the general build that takes the count from the config at run time
+
+// one slot per core: a plain array when the count is fixed, a vector otherwise
+template <class T, int CORES>
+class CoreSlots {
+    private:
+        T SLOTS[CORES];
+
+    public:
+        CoreSlots(int cores, T fill) { for (int i = 0; i < CORES; i++) SLOTS[i] = fill; }
+        T& operator[](int i) { return SLOTS[i]; }
+};
+
+template <class T>
+class CoreSlots<T, 0> {
+    private:
+        vector<T> SLOTS;
+
+    public:
+        CoreSlots(int cores, T fill) : SLOTS(cores, fill) {};
+        T& operator[](int i) { return SLOTS[i]; }
+};
+
+// core count an engine built for CORES runs with
+template <int CORES>
+inline int core_count(const SimConfig& config) { return CORES > 0 ? CORES : config.cores; }
+
+// call run with the core count as an integral_constant: the specialized build for the
+// common counts, the general one (0) for anything else
+template <class Run>
+void with_core_count(int cores, Run run) {
+    switch (cores) {
+        case 4: run(integral_constant<int, 4>()); break;
+        case 8: run(integral_constant<int, 8>()); break;
+        case 16: run(integral_constant<int, 16>()); break;
+        case 32: run(integral_constant<int, 32>()); break;
+        case 64: run(integral_constant<int, 64>()); break;
+        default: run(integral_constant<int, 0>()); break;
+    }
+}
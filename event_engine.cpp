@@ -0,0 +1,384 @@
+#pragma once
+#include "tick_engine.cpp"
+#include "policy.cpp"
+#include "io.cpp"
+#include "tracer.cpp"
+#include "profile.cpp"
+#include <algorithm>
+#include <functional>
+
+///////////////////////////////////////////////////
+///// EVENT ENGINE ////////////////////////////////
+///////////////////////////////////////////////////
+
+// discrete-event version of run_tick_sim.  instead of stepping every RRTIME and
+// scanning every process and core, it only visits the points where something changes:
+// arrivals, quantum expiries / burst completions, dispatch passes and io completions.
+// the model is still the tick model (dispatching happens on RRTIME boundaries and io
+// gets RRTIME of service per boundary), so with the reserved policy and a single fifo io
+// channel turnaround, wait and response come out the same.
+// the per-process times are accounted the same way as in the tick loop, on state changes:
+//  - turnaround: RRTIME * (finish tick - arrival tick) + cpu time
+//  - response: RRTIME * (dispatch tick - ready tick)
+//  - wait: time the io burst finished (its tick plus how far into that tick's io budget) minus
+//    the time the process entered the wait queue
+
+// phases within one tick, in the same order as the sections of the tick loop
+enum EventPhase {
+    EV_CPU = 0, // end of the quanta loaded on the last dispatch pass: burst completions or quantum expiries
+    EV_DISPATCH = 1, // load ready processes onto the free cores
+    EV_ARRIVAL = 2, // processes enter their ready queues, to be dispatched from the next tick
+    EV_IO = 3 // io burst serviced (partially or to completion), in order of the point in the tick's io budget
+};
+
+struct SimEvent {
+    int tick; // pass number the event happens on (time = tick * RRTIME)
+    int phase; // EventPhase
+    int offset; // io events: point in the tick's io budget the burst finished at (RRTIME if partial)
+    long long order; // sequence number: a streamed trace can push more than 2^31 events
+    int proc; // row of the process in the process table
+    int amount; // io events: what was left of the burst at the start of the tick if partial, its length if done
+    int channel; // io events: io channel serving the burst
+    bool done; // io events: whether this finishes the burst
+
+    bool operator>(const SimEvent& other) const {
+        if (tick != other.tick) return tick > other.tick;
+        if (phase != other.phase) return phase > other.phase;
+        if (offset != other.offset) return offset > other.offset;
+        return order > other.order;
+    }
+};
+
+// where the event engine gets its processes from.  a source hands out rows of its
+// process table as their arrival tick comes up and is told when a row is done with:
+//  - ProcessTable& table()  table the rows live in
+//  - int next_arrival()     arrival tick of the next process, or -1 once there are none left
+//  - int admit()            row of that process, with its workload columns filled in
+//  - void retire(int row, int tick)  the process left the system on tick; its TURNAROUND, WAIT and RESPONSE are final
+// admit() may move the table's columns (a streaming source grows its table as the active set
+// grows), so the engine goes through the table for every access instead of caching columns
+
+// every process of an already loaded table, arriving at its ARRIVAL time
+struct TableSource {
+    ProcessTable& procs;
+    int rrtime;
+    int * order; // rows in arrival order
+    int next = 0; // next entry of order to admit
+
+    TableSource(ProcessTable& table, int quantum, Arena& arena) : procs(table), rrtime(quantum), order(arena.alloc<int>(table.count)) {
+        arrival_order(procs, rrtime, order);
+    };
+    ProcessTable& table() { return procs; }
+    int next_arrival() const { return next < procs.count ? arrival_tick(procs.ARRIVAL[order[next]], rrtime) : -1; }
+    int admit() { return order[next++]; }
+    void retire(int row, int tick) {} // results stay in the table
+};
+
+// only the burst cursors, STATE, TURNAROUND, WAIT and RESPONSE and the accounting columns
+// of the source's table are written.  the per-run scratch columns come from the run's arena.  which ready process
+// runs on which core is up to policy (see policy.cpp), and which waiting burst each io
+// channel serves next is up to io (see io.cpp).  built for CORES cores, or config.cores if
+// CORES is 0 (see config.cpp).  every dispatch, preemption, io start and end and finish goes
+// to tracer if there is one (see tracer.cpp)
+template <int CORES, class Source, class Policy>
+void run_event_sim(Source& source, Policy& policy, IoDevices& io, const SimConfig& config, Arena& arena, SimCounters& counters,
+                   EventTracer * tracer = nullptr) {
+    PROFILE_PHASE(PH_ENGINE);
+    ProcessTable& procs = source.table();
+    const int CORECOUNT = core_count<CORES>(config);
+    const int RRTIME = config.rrtime;
+    const int SWITCHCOST = config.switchcost;
+    const int MIGRATIONCOST = config.migrationcost;
+    const bool AFFINITY = config.affinity != 0;
+
+    // per-process run state, grown along with the rows the source hands out
+    int capacity = procs.count;
+    int * entry_tick = arena.fill<int>(capacity, -1); // tick the process entered the system, -1 if not in it
+    int * ready_tick = arena.fill<int>(capacity, 0); // tick the process last became ready (state 1)
+    long long * io_entry = arena.fill<long long>(capacity, 0); // time the process entered the wait queue, in ms
+
+    priority_queue<SimEvent, vector<SimEvent>, greater<SimEvent>> events;
+    long long seq = 0;
+
+    int io_pending = 0; // processes queued on or being served by an io device
+    int running = 0; // cores loaded with a quantum that has not ended yet
+    CoreSlots<int, CORES> core_last(CORECOUNT, -1); // row each core last ran, -1 if none
+    // the quanta of a dispatch pass all end on the next tick before anything else happens on
+    // it, so they share one EV_CPU event and are kept here: the cores loaded, in core order,
+    // and the row and switching overhead on each
+    CoreSlots<int, CORES> loaded(CORECOUNT, -1);
+    CoreSlots<int, CORES> on_core(CORECOUNT, -1);
+    CoreSlots<int, CORES> core_over(CORECOUNT, 0); // ms of the quantum lost to switching onto the core
+    int loaded_count = 0;
+    CoreSlots<int, CORES> placed(CORECOUNT, -1); // dispatch pass scratch: row each core runs next
+
+    int dispatch_tick = -1; // latest tick a dispatch pass has been scheduled for
+    long long dispatched_total = 0; // sum of cores loaded over every dispatch pass
+    int full_passes = 0; // dispatch passes that loaded every core
+    int last_pass_tick = -1, last_pass_count = 0;
+
+    long long cpu_bursts = 0;
+    long long migrations = 0;
+    long long switches = 0;
+    long long switch_time = 0;
+    long long migration_time = 0;
+    int final_cpu_time = 0;
+    int final_io_time = 0;
+
+    auto schedule_dispatch = [&](int tick) {
+        if (dispatch_tick < tick) {
+            events.push({tick, EV_DISPATCH, 0, seq++, -1, 0, -1, false});
+            dispatch_tick = tick;
+        }
+    };
+
+    // a channel starts on this burst at time ms.  work out where it finishes, mirroring the
+    // per-tick io budget of the tick loop: while the burst runs out of budget, it gets what is
+    // left of the tick and the rest carries over to the next one
+    auto start_io = [&](int p, int channel, long long time) {
+        int length = procs.IO_LEFT[p];
+        int burst = length;
+        int io_tick = time / RRTIME;
+        int io_used = time % RRTIME;
+        if (tracer) tracer->record(TR_IO_START, time, procs.PID[p], channel);
+        while (io_used + burst > RRTIME) {
+            events.push({io_tick, EV_IO, RRTIME, seq++, p, burst, channel, false});
+            burst -= RRTIME - io_used;
+            io_tick++;
+            io_used = 0;
+        }
+        events.push({io_tick, EV_IO, io_used + burst, seq++, p, length, channel, true});
+    };
+
+    // the process leaves the system: turnaround is RRTIME for every pass it was alive
+    // on top of the cpu time already added on each burst completion
+    auto finish = [&](int p, int tick) {
+        procs.STATE[p] = 4;
+        procs.FINISH[p] = static_cast<long long>(tick) * RRTIME;
+        // the row may be handed to a new process, which has nothing left on any core
+        if (procs.LAST_CORE[p] >= 0 && core_last[procs.LAST_CORE[p]] == p) core_last[procs.LAST_CORE[p]] = -1;
+        if (tracer) tracer->record(TR_FINISH, static_cast<long long>(tick) * RRTIME, procs.PID[p], -1);
+        procs.TURNAROUND[p] += RRTIME * (tick - entry_tick[p]);
+        entry_tick[p] = -1;
+        source.retire(p, tick);
+    };
+
+    if (source.next_arrival() >= 0) events.push({source.next_arrival(), EV_ARRIVAL, 0, seq++, -1, 0, -1, false});
+
+    int tick = 0;
+    while (!events.empty()) {
+        SimEvent ev = events.top();
+        if (ev.tick != tick) {
+            // end of a tick: stop once nothing is queued and nothing more is coming, same check as the tick loop
+            if (tick > 0 && policy.empty() && io_pending == 0 && running == 0 && source.next_arrival() < 0) break;
+            tick = ev.tick;
+            PROFILE_PASS();
+        }
+        events.pop();
+        int p = ev.proc;
+
+        if (ev.phase == EV_ARRIVAL) {
+            PROFILE_PHASE(PH_ARRIVALS);
+            // everything arriving on this tick joins its ready queue in source order
+            while (source.next_arrival() >= 0 && source.next_arrival() <= tick) {
+                p = source.admit();
+                if (p >= capacity) {
+                    int grown = max(p + 1, 2 * capacity);
+                    entry_tick = arena.grow(entry_tick, capacity, grown);
+                    ready_tick = arena.grow(ready_tick, capacity, grown);
+                    io_entry = arena.grow(io_entry, capacity, grown);
+                    for (int i = capacity; i < grown; i++) entry_tick[i] = -1;
+                    capacity = grown;
+                }
+                procs.rewind(p);
+                procs.STATE[p] = 1;
+                procs.TURNAROUND[p] = 0;
+                procs.WAIT[p] = 0;
+                procs.RESPONSE[p] = 0;
+                entry_tick[p] = tick;
+                procs.clear_accounting(p);
+                if (procs.PRIORITY[p] < 1 || procs.PRIORITY[p] > 3) { cerr << "Invalid process priority.\n"; continue; }
+                policy.admit(p);
+                policy.enqueue(p, tick);
+                ready_tick[p] = tick;
+                schedule_dispatch(tick + 1);
+            }
+            if (source.next_arrival() >= 0) events.push({source.next_arrival(), EV_ARRIVAL, 0, seq++, -1, 0, -1, false});
+        } else if (ev.phase == EV_CPU) {
+            PROFILE_PHASE(PH_RUNNING);
+            // every core loaded on the last pass, in core order
+            for (int k = 0; k < loaded_count; k++) {
+                int core = loaded[k];
+                p = on_core[core];
+                running--;
+                int budget = RRTIME - core_over[core]; // what switching onto the core left of the quantum
+                int time = procs.CPU_LEFT[p] - budget;
+                policy.charge(p, time <= 0 ? procs.CPU_LEFT[p] : budget);
+                if (time <= 0) { // burst complete
+                    int used = core_over[core] + procs.CPU_LEFT[p];
+                    if (tracer) tracer->record(TR_BURST_END, static_cast<long long>(tick - 1) * RRTIME + used, procs.PID[p], core);
+                    procs.TURNAROUND[p] += used;
+                    final_cpu_time = used;
+                    cpu_bursts++;
+                    procs.next_cpu(p);
+                    if (procs.has_io(p)) {
+                        procs.STATE[p] = 2;
+                        io_entry[p] = static_cast<long long>(tick) * RRTIME;
+                        io_pending++;
+                        int channel = io.submit(p);
+                        if (channel >= 0) start_io(p, channel, io_entry[p]);
+                    } else {
+                        finish(p, tick);
+                    }
+                } else { // quantum expired: back of its queue, still flagged as running
+                    procs.CPU_LEFT[p] = time;
+                    if (tracer) tracer->record(TR_PREEMPT, static_cast<long long>(tick) * RRTIME, procs.PID[p], core);
+                    policy.preempt(p, tick);
+                    schedule_dispatch(tick);
+                }
+            }
+            loaded_count = 0;
+        } else if (ev.phase == EV_DISPATCH) {
+            PROFILE_PHASE(PH_DISPATCH);
+            // every core is free again on a dispatch pass (each one ran a single quantum).
+            // the policy fills them in core order, first with work meant for each core
+            // and then whatever is left over goes to the cores still free
+            int count = 0;
+            for (int round = 0; round < 2 && !policy.empty(); round++) {
+                for (int core = 0; core < CORECOUNT && !policy.empty(); core++) {
+                    if (placed[core] >= 0) continue;
+                    int proc = policy.pick(core, round == 1);
+                    if (proc < 0) continue;
+                    placed[core] = proc;
+                    count++;
+                }
+            }
+            // affinity: the policy picked who runs, now move each one back to the core it last
+            // ran on if that core is free or holds a process that did not run there last
+            if (AFFINITY) {
+                for (int core = 0; core < CORECOUNT; core++) {
+                    int proc = placed[core];
+                    if (proc < 0) continue;
+                    int home = procs.LAST_CORE[proc];
+                    if (home < 0 || home == core) continue;
+                    int other = placed[home];
+                    if (other >= 0 && procs.LAST_CORE[other] == home) continue;
+                    placed[home] = proc;
+                    placed[core] = other;
+                }
+            }
+            for (int core = 0; core < CORECOUNT && loaded_count < count; core++) {
+                int proc = placed[core];
+                if (proc < 0) continue;
+                placed[core] = -1; // clean for the next pass
+                if (procs.STATE[proc] == 1) procs.RESPONSE[proc] += RRTIME * (tick - ready_tick[proc]);
+                procs.STATE[proc] = 3;
+                if (procs.FIRST_DISPATCH[proc] < 0) procs.FIRST_DISPATCH[proc] = static_cast<long long>(tick) * RRTIME;
+                // what the switch onto this core costs the quantum
+                int overhead = 0;
+                if (procs.LAST_CORE[proc] >= 0 && procs.LAST_CORE[proc] != core) {
+                    migrations++;
+                    procs.MIGRATIONS[proc]++;
+                    overhead += MIGRATIONCOST;
+                    migration_time += MIGRATIONCOST;
+                }
+                procs.LAST_CORE[proc] = core;
+                if (core_last[core] != proc) {
+                    switches++;
+                    procs.SWITCHES[proc]++;
+                    core_last[core] = proc;
+                    overhead += SWITCHCOST;
+                    switch_time += SWITCHCOST;
+                }
+                if (tracer) tracer->record(TR_DISPATCH, static_cast<long long>(tick) * RRTIME, procs.PID[proc], core);
+                loaded[loaded_count++] = core;
+                on_core[core] = proc;
+                core_over[core] = overhead;
+                running++;
+            }
+            if (count > 0) events.push({tick + 1, EV_CPU, 0, seq++, -1, 0, -1, false});
+            // anything that did not fit gets another pass on the next tick
+            if (!policy.empty()) schedule_dispatch(tick + 1);
+            dispatched_total += count;
+            if (count == CORECOUNT) full_passes++;
+            last_pass_tick = tick;
+            last_pass_count = count;
+        } else { // EV_IO
+            PROFILE_PHASE(PH_IO);
+            if (!ev.done) { final_io_time = ev.amount; continue; }
+            // waited from entering the queue until the burst finished, part way into the tick
+            long long time = static_cast<long long>(tick) * RRTIME + ev.offset;
+            procs.WAIT[p] += time - io_entry[p];
+            if (tracer) tracer->record(TR_IO_END, time, procs.PID[p], ev.channel);
+            // the channel moves on to the next burst of its device right away
+            int next = io.complete(ev.channel, ev.amount, time - io_entry[p]);
+            if (next >= 0) start_io(next, ev.channel, time);
+            procs.next_io(p);
+            io_pending--;
+            if (procs.has_cpu(p)) {
+                procs.STATE[p] = 1;
+                ready_tick[p] = tick;
+                policy.enqueue(p, tick);
+                schedule_dispatch(tick + 1);
+            } else {
+                finish(p, tick);
+            }
+        }
+    }
+    if (tick == 0) tick = 1; // the tick loop always makes at least one pass
+
+    // the tick loop sees the cores loaded on pass t while handling pass t + 1,
+    // so the dispatch pass made on the final tick never shows up in the idle times
+    if (last_pass_tick == tick) {
+        dispatched_total -= last_pass_count;
+        if (last_pass_count == CORECOUNT) full_passes--;
+    }
+
+    // whatever is still in the system was alive up to the last pass
+    for (int i = 0; i < capacity; i++) {
+        if (entry_tick[i] >= 0) {
+            procs.TURNAROUND[i] += RRTIME * (tick - entry_tick[i]);
+            source.retire(i, tick);
+        }
+    }
+
+    counters.simruntime = static_cast<long long>(RRTIME) * tick + final_cpu_time + final_io_time;
+    counters.core_idle = RRTIME * (static_cast<long long>(CORECOUNT) * tick - dispatched_total);
+    counters.cpu_idle = static_cast<long long>(RRTIME) * (tick - full_passes);
+    counters.cpu_bursts = cpu_bursts;
+    counters.migrations = migrations;
+    counters.dispatches = dispatched_total;
+    counters.switches = switches;
+    counters.switch_time = switch_time;
+    counters.migration_time = migration_time;
+    counters.steals = policy.steals();
+    counters.io = io.stats();
+}
+
+// run with the core count of config, through the specialized build if there is one for it
+template <class Source, class Policy>
+void run_event_sim(Source& source, Policy& policy, IoDevices& io, const SimConfig& config, Arena& arena, SimCounters& counters,
+                   EventTracer * tracer = nullptr) {
+    with_core_count(config.cores, [&](auto cores) { run_event_sim<decltype(cores)::value>(source, policy, io, config, arena, counters, tracer); });
+}
+
+// run with the configured policy: reserved (the original scheme), srt, mlfq, cfs or percore,
+// and the configured io devices
+template <class Source>
+void run_event_sim(Source& source, const PolicyConfig& policy, const IoConfig& devices, const SimConfig& config, Arena& arena, SimCounters& counters,
+                   EventTracer * tracer = nullptr) {
+    ProcessTable& procs = source.table();
+    IoDevices io(procs, devices);
+    if (policy.name == "srt") { SrtPolicy srt(procs); run_event_sim(source, srt, io, config, arena, counters, tracer); }
+    else if (policy.name == "mlfq") { MlfqPolicy mlfq(procs, config); run_event_sim(source, mlfq, io, config, arena, counters, tracer); }
+    else if (policy.name == "cfs") { CfsPolicy cfs(procs); run_event_sim(source, cfs, io, config, arena, counters, tracer); }
+    else if (policy.name == "percore") { PerCorePolicy percore(procs, config, policy.reserve); run_event_sim(source, percore, io, config, arena, counters, tracer); }
+    else { ReservedPolicy reserved(procs, config); run_event_sim(source, reserved, io, config, arena, counters, tracer); }
+}
+
+// run over every process of an already loaded table
+void run_event_sim(ProcessTable& procs, const PolicyConfig& policy, const IoConfig& devices, const SimConfig& config, Arena& arena, SimCounters& counters,
+                   EventTracer * tracer = nullptr) {
+    TableSource source(procs, config.rrtime, arena);
+    run_event_sim(source, policy, devices, config, arena, counters, tracer);
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <climits>
+#include <cstring>
+#include <iostream>
+using namespace std;
+
+///////////////////////////////////////////////////
+///// LATENCY HISTOGRAMS //////////////////////////
+///////////////////////////////////////////////////
+
+// log-bucketed histogram of non-negative int values (times in ms).  values below SUB get a
+// bucket each; above that every power of two is split into SUB buckets, so a bucket is never
+// wider than 1/SUB of the values in it and percentiles come out within about 3%.  the size is
+// fixed however many values go in, and two histograms merge by adding up their buckets
+class Histogram {
+    private:
+        static const int SUB_BITS = 5;
+        static const int SUB = 1 << SUB_BITS;
+        static const int BUCKETS = (32 - SUB_BITS) * SUB; // enough for any non-negative int
+
+        long long COUNTS[BUCKETS];
+
+        static int bucket(int value) {
+            if (value < SUB) return value;
+            int top = 31 - __builtin_clz(value); // highest set bit, at least SUB_BITS
+            return (top - SUB_BITS + 1) * SUB + ((value >> (top - SUB_BITS)) - SUB);
+        }
+
+        // smallest and largest value that land in bucket b
+        static long long lowest(int b) {
+            if (b < SUB) return b;
+            int top = b / SUB + SUB_BITS - 1;
+            return static_cast<long long>(SUB + b % SUB) << (top - SUB_BITS);
+        }
+        static long long highest(int b) {
+            if (b < SUB) return b;
+            int top = b / SUB + SUB_BITS - 1;
+            return lowest(b) + (1LL << (top - SUB_BITS)) - 1;
+        }
+
+    public:
+        long long count = 0;
+        long long sum = 0;
+        int min = INT_MAX;
+        int max = 0;
+
+        Histogram() { memset(COUNTS, 0, sizeof(COUNTS)); }
+
+        void add(int value) {
+            if (value < 0) value = 0;
+            COUNTS[bucket(value)]++;
+            count++;
+            sum += value;
+            if (value < min) min = value;
+            if (value > max) max = value;
+        }
+
+        void merge(const Histogram& other) {
+            for (int b = 0; b < BUCKETS; b++) COUNTS[b] += other.COUNTS[b];
+            count += other.count;
+            sum += other.sum;
+            if (other.min < min) min = other.min;
+            if (other.max > max) max = other.max;
+        }
+
+        // buckets and totals as raw bytes, for partial result files (see partial.cpp)
+        void save(ostream& out) const {
+            out.write(reinterpret_cast<const char *>(COUNTS), sizeof(COUNTS));
+            out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+            out.write(reinterpret_cast<const char *>(&sum), sizeof(sum));
+            out.write(reinterpret_cast<const char *>(&min), sizeof(min));
+            out.write(reinterpret_cast<const char *>(&max), sizeof(max));
+        }
+        bool load(istream& in) {
+            in.read(reinterpret_cast<char *>(COUNTS), sizeof(COUNTS));
+            in.read(reinterpret_cast<char *>(&count), sizeof(count));
+            in.read(reinterpret_cast<char *>(&sum), sizeof(sum));
+            in.read(reinterpret_cast<char *>(&min), sizeof(min));
+            in.read(reinterpret_cast<char *>(&max), sizeof(max));
+            return in.good();
+        }
+
+        double mean() const { return count > 0 ? static_cast<double>(sum) / count : 0.0; }
+
+        // value at or below which fraction q of the values lie: the middle of the bucket the
+        // q * count'th smallest value is in, kept within the smallest and largest value seen
+        long long percentile(double q) const {
+            if (count == 0) return 0;
+            long long rank = static_cast<long long>(q * count);
+            if (rank < q * count) rank++; // round up
+            if (rank < 1) rank = 1;
+            long long seen = 0;
+            for (int b = 0; b < BUCKETS; b++) {
+                seen += COUNTS[b];
+                if (seen >= rank) {
+                    long long value = (lowest(b) + highest(b)) / 2;
+                    return value < min ? min : value > max ? max : value;
+                }
+            }
+            return max;
+        }
+};
+
+// the latency distributions the report is made of, one value per process
+struct LatencyHistograms {
+    Histogram turnaround;
+    Histogram wait;
+    Histogram response;
+
+    void add(int turnaround_ms, int wait_ms, int response_ms) {
+        turnaround.add(turnaround_ms);
+        wait.add(wait_ms);
+        response.add(response_ms);
+    }
+
+    void merge(const LatencyHistograms& other) {
+        turnaround.merge(other.turnaround);
+        wait.merge(other.wait);
+        response.merge(other.response);
+    }
+
+    void save(ostream& out) const {
+        turnaround.save(out);
+        wait.save(out);
+        response.save(out);
+    }
+    bool load(istream& in) { return turnaround.load(in) && wait.load(in) && response.load(in); }
+};
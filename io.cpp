@@ -0,0 +1,130 @@
+#pragma once
+#include "pcb.cpp"
+#include "config.cpp"
+#include <climits>
+#include <queue>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+///////////////////////////////////////////////////
+///// IO DEVICES //////////////////////////////////
+///////////////////////////////////////////////////
+
+// which io devices the event engine models.  every process does all of its io on device
+// PID % devices.  a device has a queue and some number of channels; each channel serves one
+// burst at a time with RRTIME of service per tick, like the single device of the tick loop,
+// so the default of one fifo device with one channel is the tick loop's model
+struct IoConfig {
+    int devices = 1;
+    int channels = 1; // bursts a device serves at once
+    string discipline = "fifo"; // fifo, sjf or elevator
+};
+
+// what one device did over a run
+struct IoDeviceStats {
+    long long busy = 0; // io time served, in ms, over all its channels
+    long long queued = 0; // time bursts spent queued before a channel took them, in ms (queue depth integrated over time)
+    int peak_queue = 0; // most bursts queued at once
+};
+
+// queues and channels of every device.  the queue is an ordered set keyed by the discipline:
+//  - fifo: order the burst was queued in
+//  - sjf: length of the burst, shortest first, then queue order
+//  - elevator: track the burst is on.  the head sweeps up taking the nearest burst at or above
+//    it, turns around when there is nothing further up, and sweeps down the same way
+// so every discipline queues and picks in O(log n).  fifo, the common case, skips the set for a
+// plain queue per device, which takes no allocation per burst
+class IoDevices {
+    private:
+        ProcessTable& PROCS;
+        IoConfig CONFIG;
+        int KIND; // 0 fifo, 1 sjf, 2 elevator
+        vector<set<tuple<int, long long, int>>> QUEUE; // (key, queue order, row) per device
+        vector<queue<int>> FIFO; // fifo: rows in queue order per device
+        vector<int> SERVING; // row each channel is serving, -1 if idle, channels of device d start at d * channels
+        vector<int> HEAD; // elevator: track of the last burst started on each device
+        vector<bool> UP; // elevator: direction each device's head is sweeping in
+        vector<IoDeviceStats> STATS;
+        long long ORDER;
+
+        // track an io burst sits on, spread evenly over IOTRACKS by its process and burst number
+        int track(int p) const {
+            unsigned int h = static_cast<unsigned int>(PROCS.PID[p]) * 2654435761u;
+            h ^= static_cast<unsigned int>(PROCS.IO_NEXT[p] - PROCS.IO_BEGIN[p] + 1) * 40503u;
+            h ^= h >> 15;
+            return h % IOTRACKS;
+        }
+
+        // take the next burst off device d's queue, -1 if it is empty
+        int take(int d) {
+            if (KIND == 0) {
+                if (FIFO[d].empty()) return -1;
+                int p = FIFO[d].front();
+                FIFO[d].pop();
+                return p;
+            }
+            set<tuple<int, long long, int>>& queue = QUEUE[d];
+            if (queue.empty()) return -1;
+            set<tuple<int, long long, int>>::iterator it = queue.begin();
+            if (KIND == 2) {
+                if (UP[d]) {
+                    it = queue.lower_bound(make_tuple(HEAD[d], LLONG_MIN, INT_MIN));
+                    if (it == queue.end()) { UP[d] = false; it = prev(queue.end()); }
+                } else {
+                    it = queue.upper_bound(make_tuple(HEAD[d], LLONG_MAX, INT_MAX));
+                    if (it == queue.begin()) UP[d] = true;
+                    else it = prev(it);
+                }
+                HEAD[d] = get<0>(*it);
+            }
+            int p = get<2>(*it);
+            queue.erase(it);
+            return p;
+        }
+
+    public:
+        IoDevices(ProcessTable& procs, const IoConfig& config)
+            : PROCS(procs), CONFIG(config), QUEUE(config.devices), FIFO(config.devices), SERVING(config.devices * config.channels, -1),
+              HEAD(config.devices, 0), UP(config.devices, true), STATS(config.devices), ORDER(0) {
+            KIND = config.discipline == "sjf" ? 1 : config.discipline == "elevator" ? 2 : 0;
+        };
+
+        int device(int p) const { return (PROCS.PID[p] % CONFIG.devices + CONFIG.devices) % CONFIG.devices; }
+
+        // p has an io burst for its device.  returns the channel that starts on it right away,
+        // or -1 if every channel is busy and it was queued
+        int submit(int p) {
+            int d = device(p);
+            for (int c = d * CONFIG.channels; c < (d + 1) * CONFIG.channels; c++) {
+                if (SERVING[c] < 0) {
+                    SERVING[c] = p;
+                    if (KIND == 2) HEAD[d] = track(p);
+                    return c;
+                }
+            }
+            int queued;
+            if (KIND == 0) {
+                FIFO[d].push(p);
+                queued = FIFO[d].size();
+            } else {
+                QUEUE[d].insert(make_tuple(KIND == 1 ? PROCS.IO_LEFT[p] : track(p), ORDER++, p));
+                queued = QUEUE[d].size();
+            }
+            if (queued > STATS[d].peak_queue) STATS[d].peak_queue = queued;
+            return -1;
+        }
+
+        // the burst on channel finished after being served for length ms and waiting waited ms
+        // in all.  returns the row the channel takes next, -1 if the device's queue is empty
+        int complete(int channel, int length, long long waited) {
+            int d = channel / CONFIG.channels;
+            STATS[d].busy += length;
+            STATS[d].queued += waited - length;
+            SERVING[channel] = take(d);
+            return SERVING[channel];
+        }
+
+        const vector<IoDeviceStats>& stats() const { return STATS; }
+};
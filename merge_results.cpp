@@ -0,0 +1,108 @@
+// combines the partial result files of a campaign run in shards (simulation --shard=K/N) into
+// the results.txt and latency file a single invocation over all the runs would have written,
+// byte for byte.  the shards can come in any order but must all be there, once each, and
+// must agree on the seed, the run count and the setup.
+// build and run: g++ -O2 merge_results.cpp -o merge_results && ./merge_results partial-*.bin [--latency=FILE]
+//  --latency  where to write the percentiles; json if the name ends in .json (default latency.csv)
+#include "pcb.cpp"
+#include "rng.cpp"
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include "report.cpp"
+#include "partial.cpp"
+
+// the parameters, io setup and policy the shards ran with, out of the setup text.  the other keys
+// only have to match between shards.  false if the text does not parse
+bool parse_setup(const string& text, SimConfig& config, IoConfig& io, string& policy) {
+    stringstream in(text), parameters;
+    string line;
+    while (getline(in, line)) {
+        size_t eq = line.find(" = ");
+        if (eq == string::npos) { cerr << "Bad setup line: " << line << endl; return false; }
+        string key = line.substr(0, eq), value = line.substr(eq + 3);
+        if (key == "io-devices") io.devices = atoi(value.c_str());
+        else if (key == "io-channels") io.channels = atoi(value.c_str());
+        else if (key == "policy") policy = value;
+        else if (key == "engine" || key == "reserve" || key == "io-discipline" ||
+                 key == "arrival-rate" || key == "workload") continue;
+        else parameters << line << "\n";
+    }
+    return config.read(parameters);
+}
+
+int main(int argc, char * argv[]) {
+    string latency_path = "latency.csv";
+    vector<string> paths;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--latency=", 10) == 0) latency_path = argv[i] + 10;
+        else if (strncmp(argv[i], "--", 2) == 0) { cerr << "Unknown argument: " << argv[i] << endl; return 1; }
+        else paths.push_back(argv[i]);
+    }
+    if (paths.empty()) { cerr << "usage: merge_results PARTIAL... [--latency=FILE]\n"; return 1; }
+
+    // the first file sets what every other one has to match
+    PartialResults first;
+    if (!first.load(paths[0])) return 1;
+    vector<SimMetrics> results(first.runcount);
+    vector<bool> have_shard(first.shards, false);
+    vector<bool> have_run(first.runcount, false);
+    LatencyHistograms latency;
+    for (int p = 0; p < paths.size(); p++) {
+        PartialResults partial;
+        if (p == 0) partial = first;
+        else if (!partial.load(paths[p])) return 1;
+        if (partial.seed != first.seed || partial.runcount != first.runcount || partial.shards != first.shards) {
+            cerr << paths[p] << " is from another campaign than " << paths[0] << " (seed, runs or shard count differ).\n";
+            return 1;
+        }
+        if (partial.setup != first.setup) { cerr << paths[p] << " was run with another setup than " << paths[0] << ".\n"; return 1; }
+        if (have_shard[partial.shard]) { // load has checked it is in range
+            cerr << paths[p] << ": shard " << partial.shard << " of " << partial.shards << " is given twice.\n";
+            return 1;
+        }
+        have_shard[partial.shard] = true;
+        if (partial.first_run < 0 || partial.first_run + static_cast<long long>(partial.results.size()) > partial.runcount) {
+            cerr << paths[p] << ": runs out of range.\n";
+            return 1;
+        }
+        for (int r = 0; r < partial.results.size(); r++) {
+            int simrun = partial.first_run + r;
+            if (have_run[simrun]) { cerr << paths[p] << ": run " << simrun + 1 << " is in another shard too.\n"; return 1; }
+            have_run[simrun] = true;
+            results[simrun] = partial.results[r];
+        }
+        latency.merge(partial.latency);
+    }
+    for (int s = 0; s < first.shards; s++) {
+        if (!have_shard[s]) { cerr << "Shard " << s << " of " << first.shards << " is missing.\n"; return 1; }
+    }
+    for (int simrun = 0; simrun < first.runcount; simrun++) {
+        if (!have_run[simrun]) { cerr << "Run " << simrun + 1 << " is in no shard.\n"; return 1; }
+    }
+
+    SimConfig config;
+    IoConfig io;
+    string policy = "reserved";
+    if (!parse_setup(first.setup, config, io, policy)) return 1;
+
+    ofstream output("results.txt");
+    if (!output.is_open()) { cerr << "Error opening results.txt.\n"; return 1; }
+    stringstream heading;
+    heading << " -- Over " << first.runcount << " runs (seed " << first.seed << ") -- " << endl;
+    int mismatches = write_results(output, heading.str(), results, latency, config, io, verify_failure(policy));
+    output.close();
+
+    ofstream latency_file(latency_path);
+    if (!latency_file.is_open()) { cerr << "Error opening latency file " << latency_path << ".\n"; return 1; }
+    bool json = latency_path.size() >= 5 && latency_path.compare(latency_path.size() - 5, 5, ".json") == 0;
+    write_latency(latency_file, latency, json);
+    latency_file.close();
+
+    if (mismatches > 0) {
+        cerr << mismatches << " of " << first.runcount << " runs did not match.\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include "simulator.cpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////
+///// PARTIAL RESULTS /////////////////////////////
+///////////////////////////////////////////////////
+
+// what one shard of a seeded campaign found, for merge_results.cpp to combine with the other
+// shards into the results.txt and latency file a single invocation would have written.  a
+// shard is the runs [first_run, first_run + runs) of the campaign's runcount.  every run's
+// metrics are kept rather than their sums: the averages of the double metrics are summed in
+// run order, and only the same additions in the same order give the same last digit.  a run
+// is about a hundred bytes, the histograms are fixed size however many processes went in
+//
+// file layout: PartialHeader, the setup text, then per run a PartialRun followed by its
+// io_devices PartialDevice records, then the turnaround, wait and response histograms
+
+struct PartialHeader {
+    char magic[8]; // PARTIAL_MAGIC
+    uint64_t seed;
+    int32_t runcount; // runs in the whole campaign
+    int32_t shard;
+    int32_t shards;
+    int32_t first_run;
+    int32_t runs; // runs in this shard
+    int32_t setup_bytes; // length of the setup text that follows
+};
+
+struct PartialRun {
+    int64_t processes, simruntime, core_idle, cpu_idle, cpu_bursts, dispatches;
+    int64_t migrations, switches, switch_time, migration_time, steals;
+    double throughput;
+    int32_t turnaround_average, wait_average, response_average;
+    int32_t mismatch;
+    int32_t io_devices;
+    int32_t unused;
+};
+static_assert(sizeof(PartialRun) == 120, "partial runs are packed into 120 bytes");
+
+struct PartialDevice {
+    int64_t busy;
+    int64_t queued;
+    int32_t peak_queue;
+    int32_t unused;
+};
+
+const char PARTIAL_MAGIC[8] = {'O', 'S', 'P', 'S', 'P', 'R', '1', '\0'};
+
+struct PartialResults {
+    uint64_t seed = 0;
+    int runcount = 0;
+    int shard = 0;
+    int shards = 1;
+    int first_run = 0;
+    string setup; // everything the numbers depend on, as "key = value" lines; shards must agree on it
+    vector<SimMetrics> results; // this shard's runs, in run order
+    LatencyHistograms latency;
+
+    // the number after "key = " in the setup text, or -1 if there is no such line
+    int setup_value(const string& key) const {
+        string line = key + " = ";
+        size_t at = 0;
+        while (at < setup.size()) {
+            size_t end = setup.find('\n', at);
+            if (end == string::npos) end = setup.size();
+            if (setup.compare(at, line.size(), line) == 0) return atoi(setup.c_str() + at + line.size());
+            at = end + 1;
+        }
+        return -1;
+    }
+
+    bool save(const string& path) const {
+        ofstream out(path, ios::binary);
+        if (!out.is_open()) { cerr << "Error opening partial result file " << path << ".\n"; return false; }
+        PartialHeader header;
+        memcpy(header.magic, PARTIAL_MAGIC, sizeof(header.magic));
+        header.seed = seed;
+        header.runcount = runcount;
+        header.shard = shard;
+        header.shards = shards;
+        header.first_run = first_run;
+        header.runs = results.size();
+        header.setup_bytes = setup.size();
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(setup.data(), setup.size());
+        for (int r = 0; r < results.size(); r++) {
+            const SimMetrics& m = results[r];
+            PartialRun run = {m.processes, m.simruntime, m.core_idle, m.cpu_idle, m.cpu_bursts, m.dispatches,
+                              m.migrations, m.switches, m.switch_time, m.migration_time, m.steals, m.throughput,
+                              m.turnaround_average, m.wait_average, m.response_average, m.mismatch,
+                              static_cast<int32_t>(m.io.size()), 0};
+            out.write(reinterpret_cast<const char *>(&run), sizeof(run));
+            for (int d = 0; d < m.io.size(); d++) {
+                PartialDevice device = {m.io[d].busy, m.io[d].queued, m.io[d].peak_queue, 0};
+                out.write(reinterpret_cast<const char *>(&device), sizeof(device));
+            }
+        }
+        latency.save(out);
+        if (!out.good()) { cerr << "Error writing partial result file " << path << ".\n"; return false; }
+        return true;
+    }
+
+    bool load(const string& path) {
+        ifstream in(path, ios::binary);
+        if (!in.is_open()) { cerr << "Error opening partial result file " << path << ".\n"; return false; }
+        PartialHeader header;
+        in.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (!in || memcmp(header.magic, PARTIAL_MAGIC, sizeof(header.magic)) != 0) {
+            cerr << path << " is not a partial result file.\n";
+            return false;
+        }
+        if (header.runs < 0 || header.setup_bytes < 0 || header.runcount < 0 || header.runs > header.runcount ||
+            header.shards < 1 || header.shard < 0 || header.shard >= header.shards) {
+            cerr << path << " is damaged.\n";
+            return false;
+        }
+        seed = header.seed;
+        runcount = header.runcount;
+        shard = header.shard;
+        shards = header.shards;
+        first_run = header.first_run;
+        setup.resize(header.setup_bytes);
+        in.read(&setup[0], setup.size());
+        // a run has no more devices than the setup it ran with
+        int devices = setup_value("io-devices");
+        if (in && devices < 1) { cerr << path << " is damaged.\n"; return false; }
+        results.assign(header.runs, SimMetrics());
+        for (int r = 0; r < header.runs && in; r++) {
+            PartialRun run;
+            in.read(reinterpret_cast<char *>(&run), sizeof(run));
+            if (!in) break;
+            if (run.io_devices < 0 || run.io_devices > devices) { cerr << path << " is damaged.\n"; return false; }
+            SimMetrics& m = results[r];
+            m.processes = run.processes;
+            m.simruntime = run.simruntime;
+            m.throughput = run.throughput;
+            m.turnaround_average = run.turnaround_average;
+            m.wait_average = run.wait_average;
+            m.response_average = run.response_average;
+            m.core_idle = run.core_idle;
+            m.cpu_idle = run.cpu_idle;
+            m.cpu_bursts = run.cpu_bursts;
+            m.dispatches = run.dispatches;
+            m.migrations = run.migrations;
+            m.switches = run.switches;
+            m.switch_time = run.switch_time;
+            m.migration_time = run.migration_time;
+            m.steals = run.steals;
+            m.mismatch = run.mismatch != 0;
+            m.io.resize(run.io_devices);
+            for (int d = 0; d < run.io_devices; d++) {
+                PartialDevice device;
+                in.read(reinterpret_cast<char *>(&device), sizeof(device));
+                m.io[d].busy = device.busy;
+                m.io[d].queued = device.queued;
+                m.io[d].peak_queue = device.peak_queue;
+            }
+        }
+        if (!in || !latency.load(in)) { cerr << path << " is cut short.\n"; return false; }
+        return true;
+    }
+};
@@ -1,54 +1,207 @@
 #pragma once
+#include "arena.cpp"
 #include <iostream>
 #include <vector>
 using namespace std;
 
+// one process's accounting and results, all fixed width, for exporting in bulk
+struct ProcessRecord {
+    int pid;
+    int arrival; // ms
+    long long first_dispatch; // ms, -1 if it never got a core
+    long long finish; // ms, -1 if it never left the system
+    int last_core; // -1 if it never got a core
+    int migrations;
+    int switches; // context switches
+    int turnaround; // ms
+    int wait; // ms
+    int response; // ms
+};
+
+// column-oriented process table for one simulation run.  every attribute is its own
+// contiguous array, so the scheduler loops stream over just the columns they touch.
+// the workload columns are read-only once loaded and can live anywhere (the run's arena,
+// or a memory-mapped workload file shared by every run); the per-run columns always
+// come from the run's arena
+struct ProcessTable {
+    int count = 0; // number of processes (rows)
+
+    ///// WORKLOAD COLUMNS /////
+    const int * PID = nullptr; // process id, only used as a label: processes are referred to by row
+    const int * ARRIVAL = nullptr; // arrival time in ms
+    const int * PRIORITY = nullptr; // 1 - high, 2 - medium, 3 - low
+
+    // bursts of every process, in ms.  a process's cpu bursts are BURSTS[CPU_BEGIN[i]] up to
+    // BURSTS[CPU_END[i]], and likewise for its io bursts
+    long long burst_count = 0;
+    const int * BURSTS = nullptr;
+    const int * CPU_BEGIN = nullptr;
+    const int * CPU_END = nullptr;
+    const int * IO_BEGIN = nullptr;
+    const int * IO_END = nullptr;
+
+    ///// PER-RUN COLUMNS /////
+    int * STATE = nullptr; // 1 - ready, 2 - waiting (for IO), 3 - running, 4 - finished
+    int * TURNAROUND = nullptr; // in ms, for analysis purposes
+    int * WAIT = nullptr; // in ms, for analysis purposes
+    int * RESPONSE = nullptr; // in ms, for analysis purposes
+
+    // read cursors into the bursts, advanced in place as the simulation consumes them.
+    // CPU_NEXT / IO_NEXT index the burst currently being worked on, and CPU_LEFT / IO_LEFT
+    // hold the time left on it, so running part of a burst never touches BURSTS
+    int * CPU_NEXT = nullptr;
+    int * CPU_LEFT = nullptr;
+    int * IO_NEXT = nullptr;
+    int * IO_LEFT = nullptr;
+
+    // accounting, filled in by the engines as things happen.  times in ms, -1 if it never happened
+    // absolute times, which pass 2^31 ms on a long enough streamed trace
+    long long * FIRST_DISPATCH = nullptr; // time the process first got a core
+    long long * FINISH = nullptr; // time it left the system
+    int * LAST_CORE = nullptr; // core it last ran on, -1 if none
+    int * MIGRATIONS = nullptr; // dispatches onto a different core than the one it ran on before
+    int * SWITCHES = nullptr; // context switches: dispatches onto a core that last ran some other process
+
+    // writable handles on the workload columns, for whoever fills them in
+    struct WorkloadColumns {
+        int * pid;
+        int * arrival;
+        int * priority;
+        int * bursts;
+        int * cpu_begin;
+        int * cpu_end;
+        int * io_begin;
+        int * io_end;
+    };
+
+    // carve every column for count processes and up to burst_count bursts out of the arena.
+    // the workload columns are handed back writable so the loader can fill them in once
+    WorkloadColumns allocate(Arena& arena, int processes, long long bursts) {
+        count = processes;
+        burst_count = bursts;
+        WorkloadColumns columns = {arena.fill<int>(count, -1), arena.fill<int>(count, 0), arena.fill<int>(count, -1),
+                                   arena.alloc<int>(burst_count), arena.fill<int>(count, 0), arena.fill<int>(count, 0),
+                                   arena.fill<int>(count, 0), arena.fill<int>(count, 0)};
+        PID = columns.pid;
+        ARRIVAL = columns.arrival;
+        PRIORITY = columns.priority;
+        BURSTS = columns.bursts;
+        CPU_BEGIN = columns.cpu_begin;
+        CPU_END = columns.cpu_end;
+        IO_BEGIN = columns.io_begin;
+        IO_END = columns.io_end;
+        allocate_run_columns(arena);
+        return columns;
+    }
+
+    // give this table its own per-run columns, everything starts ready with nothing accumulated
+    void allocate_run_columns(Arena& arena) {
+        STATE = arena.fill<int>(count, 1);
+        TURNAROUND = arena.fill<int>(count, 0);
+        WAIT = arena.fill<int>(count, 0);
+        RESPONSE = arena.fill<int>(count, 0);
+        CPU_NEXT = arena.fill<int>(count, 0);
+        CPU_LEFT = arena.fill<int>(count, 0);
+        IO_NEXT = arena.fill<int>(count, 0);
+        IO_LEFT = arena.fill<int>(count, 0);
+        FIRST_DISPATCH = arena.fill<long long>(count, -1);
+        FINISH = arena.fill<long long>(count, -1);
+        LAST_CORE = arena.fill<int>(count, -1);
+        MIGRATIONS = arena.fill<int>(count, 0);
+        SWITCHES = arena.fill<int>(count, 0);
+    }
+
+    // clear the accounting of a row, for a process entering the system
+    void clear_accounting(int i) {
+        FIRST_DISPATCH[i] = -1;
+        FINISH[i] = -1;
+        LAST_CORE[i] = -1;
+        MIGRATIONS[i] = 0;
+        SWITCHES[i] = 0;
+    }
+
+    // put every cursor back on the first burst, ready for a run over the workload
+    void rewind() {
+        for (int i = 0; i < count; i++) rewind(i);
+    }
+
+    // same for a single row
+    void rewind(int i) {
+        CPU_NEXT[i] = CPU_BEGIN[i];
+        IO_NEXT[i] = IO_BEGIN[i];
+        CPU_LEFT[i] = has_cpu(i) ? BURSTS[CPU_NEXT[i]] : 0;
+        IO_LEFT[i] = has_io(i) ? BURSTS[IO_NEXT[i]] : 0;
+    }
+
+    // cursor helpers: whether there is a burst left, and moving on to the next one
+    bool has_cpu(int i) const { return CPU_NEXT[i] != CPU_END[i]; }
+    bool has_io(int i) const { return IO_NEXT[i] != IO_END[i]; }
+    void next_cpu(int i) { CPU_NEXT[i]++; CPU_LEFT[i] = has_cpu(i) ? BURSTS[CPU_NEXT[i]] : 0; }
+    void next_io(int i) { IO_NEXT[i]++; IO_LEFT[i] = has_io(i) ? BURSTS[IO_NEXT[i]] : 0; }
+
+    // everything known about row i
+    ProcessRecord record(int i) const {
+        return {PID[i], ARRIVAL[i], FIRST_DISPATCH[i], FINISH[i], LAST_CORE[i], MIGRATIONS[i], SWITCHES[i],
+                TURNAROUND[i], WAIT[i], RESPONSE[i]};
+    }
+
+    // table over the same workload with fresh per-run columns from arena
+    ProcessTable attach(Arena& arena) const {
+        ProcessTable copy = *this;
+        copy.allocate_run_columns(arena);
+        return copy;
+    }
+};
+
+// read-only view of a run of bursts, handed out instead of copying them into a vector
+struct BurstSpan {
+    const int * first;
+    const int * last;
+    int size() const { return last - first; }
+    bool empty() const { return first == last; }
+    int operator[](int i) const { return first[i]; }
+};
+
+// view of a single row of a ProcessTable with the old per-object interface
 class PCB {
     private:
-        int PID; // ranging from PIDMIN to PIDMAX specified in simulation.cpp
-        int PRIORITY; // 1 - high, 2 - medium, 3 - low
-        int STATE; // 1 - ready, 2 - waiting (for IO), 3 - running, 4 - finished
-        vector<int> IO_TIME; // in ms
-        vector<int> CPU_TIME; // in ms
-        int TURNAROUND; // in ms, for analysis purposes
-        int WAIT; // in ms, for analysis purposes
-        int RESPONSE; // in ms, for analysis purposes
+        ProcessTable * TABLE;
+        int ROW;
 
     public:
-        // empty constructor, used when initializing processes
-        PCB() : PID(-1), PRIORITY(-1), STATE(-1), IO_TIME({-1}), CPU_TIME({-1}){};
-        // specific constructor, used when reading from generated process file
-        PCB(int pid, int pri, int sta, vector<int> io, vector<int> cpu, int thr) : PID(pid), PRIORITY(pri), STATE(sta), IO_TIME(io), CPU_TIME(cpu){};
+        PCB(ProcessTable& table, int row) : TABLE(&table), ROW(row) {};
 
         // getters for each PCB attribute
-        int getPID() {return PID;}
-        int getPRIORITY() {return PRIORITY;}
-        int getSTATE() {return STATE;}
-        vector<int> getIO_TIME() {return IO_TIME;}
-        vector<int> getCPU_TIME() {return CPU_TIME;}
-        int getTURNAROUND() { return TURNAROUND; }
-        int getWAIT() { return WAIT; }
-        int getRESPONSE() { return RESPONSE; }
-
-        // setters for each PCB attribute
-        void setPID(int pid) { PID = pid; }
-        void setPRIORITY(int pri) { PRIORITY = pri; }
-        void setSTATE(int sta) { STATE = sta; }
-        void setIO_TIME(vector<int> iot) { IO_TIME = iot; }
-        void setCPU_TIME(vector<int> cpt) { CPU_TIME = cpt; }
-        void setTURNAROUND(int tur) { TURNAROUND = tur; }
-        void setWAIT(int wait) { WAIT = wait; }
-        void setRESPONSE(int res) { RESPONSE = res; }
+        int getPID() { return TABLE->PID[ROW]; }
+        int getPRIORITY() { return TABLE->PRIORITY[ROW]; }
+        int getSTATE() { return TABLE->STATE[ROW]; }
+        // bursts still to come, the first of which may already be partly used (see get*_LEFT)
+        BurstSpan getIO_TIME() { return {TABLE->BURSTS + TABLE->IO_NEXT[ROW], TABLE->BURSTS + TABLE->IO_END[ROW]}; }
+        BurstSpan getCPU_TIME() { return {TABLE->BURSTS + TABLE->CPU_NEXT[ROW], TABLE->BURSTS + TABLE->CPU_END[ROW]}; }
+        int getIO_LEFT() { return TABLE->IO_LEFT[ROW]; }
+        int getCPU_LEFT() { return TABLE->CPU_LEFT[ROW]; }
+        int getTURNAROUND() { return TABLE->TURNAROUND[ROW]; }
+        int getWAIT() { return TABLE->WAIT[ROW]; }
+        int getRESPONSE() { return TABLE->RESPONSE[ROW]; }
+
+        // setters for each per-run PCB attribute
+        void setSTATE(int sta) { TABLE->STATE[ROW] = sta; }
+        void setTURNAROUND(int tur) { TABLE->TURNAROUND[ROW] = tur; }
+        void setWAIT(int wait) { TABLE->WAIT[ROW] = wait; }
+        void setRESPONSE(int res) { TABLE->RESPONSE[ROW] = res; }
 
         // overloaded output operator.  mostly used for debugging purposes
-        friend ostream & operator<<(ostream & ostr, PCB * pcb) {
-            ostr << pcb->getPID() << ", " << pcb->getPRIORITY() << ", " << pcb->getSTATE() << ", "; 
-            for (int i = 0; i < pcb->getIO_TIME().size(); i++) {
-                ostr << pcb->getIO_TIME()[i] << ", ";
+        // prints the remaining bursts, with the time left on the current ones
+        friend ostream & operator<<(ostream & ostr, PCB pcb) {
+            ostr << pcb.getPID() << ", " << pcb.getPRIORITY() << ", " << pcb.getSTATE() << ", ";
+            BurstSpan io = pcb.getIO_TIME();
+            for (int i = 0; i < io.size(); i++) {
+                ostr << (i == 0 ? pcb.getIO_LEFT() : io[i]) << ", ";
             }
-            for (int i = 0; i < pcb->getCPU_TIME().size(); i++) {
-                ostr << pcb->getCPU_TIME()[i] << ", ";
+            BurstSpan cpu = pcb.getCPU_TIME();
+            for (int i = 0; i < cpu.size(); i++) {
+                ostr << (i == 0 ? pcb.getCPU_LEFT() : cpu[i]) << ", ";
             }
             return ostr;
         }
-};
\ No newline at end of file
+};
@@ -0,0 +1,288 @@
+#pragma once
+#include "pcb.cpp"
+#include "config.cpp"
+#include <functional>
+#include <queue>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+///////////////////////////////////////////////////
+///// SCHEDULING POLICIES /////////////////////////
+///////////////////////////////////////////////////
+
+// a policy owns the ready processes and decides which one each core runs next.
+// the event engine calls it at these points:
+//  - void admit(int p)               a new process is in row p, reset whatever the policy keeps on it
+//  - void enqueue(int p, int tick)   p became ready: it arrived or finished an io burst
+//  - void charge(int p, int used)    p just ran used ms on a core (at the end of every quantum)
+//  - void preempt(int p, int tick)   p used up its quantum with cpu time left and goes back to ready
+//  - int pick(int core, bool fill)   process for this free core, or -1.  every dispatch pass asks each
+//                                    core once with fill false (work meant for that core) and then the
+//                                    cores still free once more with fill true (anything that is left)
+//  - bool empty()                    nothing is ready
+//  - long long steals() const        processes taken from another core's run queue so far
+// rows are looked up in the table on every call, since a streaming source may move its columns.
+// every policy here picks in O(log n) or better
+
+// which policy to run and its knobs
+struct PolicyConfig {
+    string name = "reserved"; // reserved, srt, mlfq, cfs or percore
+    bool reserve = true; // percore: place processes on the cores reserved for their priority
+};
+
+// the original scheme: one FIFO per priority, half the cores reserved for high priority, a third
+// for medium and the rest for low, then any core left over goes to the highest priority waiting.
+// the same dispatch as the tick engine, so this is the one verify mode checks
+class ReservedPolicy {
+    private:
+        ProcessTable& PROCS;
+        int HIGHRES; // cores reserved for high priority, then MEDRES for medium
+        int MEDRES;
+        queue<int> READY[3]; // high, medium, low priority ready queues
+
+    public:
+        ReservedPolicy(ProcessTable& procs, const SimConfig& config)
+            : PROCS(procs), HIGHRES(SimConfig::high_reserved(config.cores)), MEDRES(SimConfig::medium_reserved(config.cores)) {};
+
+        void admit(int p) {}
+        void enqueue(int p, int tick) { READY[PROCS.PRIORITY[p] - 1].push(p); }
+        void charge(int p, int used) {}
+        void preempt(int p, int tick) { READY[PROCS.PRIORITY[p] - 1].push(p); }
+        bool empty() const { return READY[0].empty() && READY[1].empty() && READY[2].empty(); }
+        long long steals() const { return 0; }
+
+        int pick(int core, bool fill) {
+            int q;
+            if (!fill) q = core < HIGHRES ? 0 : core < HIGHRES + MEDRES ? 1 : 2;
+            else for (q = 0; q < 2 && READY[q].empty(); q++);
+            if (READY[q].empty()) return -1;
+            int p = READY[q].front();
+            READY[q].pop();
+            return p;
+        }
+};
+
+// shortest remaining time: the ready process closest to finishing its cpu burst runs first.
+// every process gives up its core at the end of each quantum, so a shorter arrival gets in
+// on the next pass.  ties go to whichever became ready first
+class SrtPolicy {
+    private:
+        ProcessTable& PROCS;
+        // (time left on the cpu burst, order it became ready, row), smallest first
+        priority_queue<tuple<int, long long, int>, vector<tuple<int, long long, int>>, greater<tuple<int, long long, int>>> HEAP;
+        long long ORDER;
+
+    public:
+        SrtPolicy(ProcessTable& procs) : PROCS(procs), ORDER(0) {};
+
+        void admit(int p) {}
+        void enqueue(int p, int tick) { HEAP.push(make_tuple(PROCS.CPU_LEFT[p], ORDER++, p)); }
+        void charge(int p, int used) {}
+        void preempt(int p, int tick) { enqueue(p, tick); }
+        bool empty() const { return HEAP.empty(); }
+        long long steals() const { return 0; }
+
+        int pick(int core, bool fill) {
+            if (HEAP.empty()) return -1;
+            int p = get<2>(HEAP.top());
+            HEAP.pop();
+            return p;
+        }
+};
+
+// multilevel feedback queue: new processes start on the top level, a process that has used up
+// its allotment of MLFQALLOT quanta on a level drops a level (however it spread them out, so
+// giving up the core just before the quantum ends does not help), and every MLFQBOOST ms
+// everything goes back to the top so long jobs cannot starve.  round robin within a level
+class MlfqPolicy {
+    private:
+        ProcessTable& PROCS;
+        int RRTIME;
+        queue<int> LEVELS[MLFQLEVELS];
+        vector<int> LEVEL; // level of each row
+        vector<int> USED; // cpu time used on its current level, in ms
+        int BOOSTED; // boost period the levels were last reset in
+        int WAITING; // processes in the level queues
+
+        void push(int p) { LEVELS[LEVEL[p]].push(p); WAITING++; }
+
+    public:
+        MlfqPolicy(ProcessTable& procs, const SimConfig& config) : PROCS(procs), RRTIME(config.rrtime), BOOSTED(0), WAITING(0) {};
+
+        void admit(int p) {
+            if (p >= LEVEL.size()) { LEVEL.resize(p + 1); USED.resize(p + 1); }
+            LEVEL[p] = 0;
+            USED[p] = 0;
+        }
+
+        void enqueue(int p, int tick) {
+            // priority boost: everything waiting moves to the top level, in level order
+            int period = static_cast<long long>(tick) * RRTIME / MLFQBOOST;
+            if (period != BOOSTED) {
+                BOOSTED = period;
+                for (int l = 1; l < MLFQLEVELS; l++) {
+                    while (!LEVELS[l].empty()) { LEVELS[0].push(LEVELS[l].front()); LEVELS[l].pop(); }
+                }
+                for (int i = 0; i < LEVEL.size(); i++) { LEVEL[i] = 0; USED[i] = 0; }
+            }
+            push(p);
+        }
+
+        void charge(int p, int used) {
+            USED[p] += used;
+            if (USED[p] >= MLFQALLOT * RRTIME && LEVEL[p] < MLFQLEVELS - 1) {
+                LEVEL[p]++;
+                USED[p] = 0;
+            }
+        }
+
+        void preempt(int p, int tick) { enqueue(p, tick); }
+        bool empty() const { return WAITING == 0; }
+        long long steals() const { return 0; }
+
+        int pick(int core, bool fill) {
+            for (int l = 0; l < MLFQLEVELS; l++) {
+                if (!LEVELS[l].empty()) {
+                    int p = LEVELS[l].front();
+                    LEVELS[l].pop();
+                    WAITING--;
+                    return p;
+                }
+            }
+            return -1;
+        }
+};
+
+// completely fair scheduling: each process accumulates virtual runtime, its cpu time scaled down
+// by its weight, and the process with the least runs next.  ready processes sit in a balanced
+// tree ordered by virtual runtime.  a process that arrives or wakes from io starts no lower than
+// the smallest virtual runtime around, so sleeping does not bank an unbounded claim on the cpu.
+// weights follow the priority: high counts about twice as much as medium, medium twice as much as low
+class CfsPolicy {
+    private:
+        ProcessTable& PROCS;
+        set<pair<long long, int>> TREE; // (virtual runtime, row) of every ready process
+        vector<long long> VRUNTIME;
+        long long MIN_VRUNTIME; // never goes backwards
+
+        static int weight(int priority) { return priority == 1 ? 1991 : priority == 2 ? 1024 : 526; }
+
+    public:
+        CfsPolicy(ProcessTable& procs) : PROCS(procs), MIN_VRUNTIME(0) {};
+
+        void admit(int p) {
+            if (p >= VRUNTIME.size()) VRUNTIME.resize(p + 1);
+            VRUNTIME[p] = MIN_VRUNTIME;
+        }
+
+        void enqueue(int p, int tick) {
+            if (VRUNTIME[p] < MIN_VRUNTIME) VRUNTIME[p] = MIN_VRUNTIME;
+            TREE.insert(make_pair(VRUNTIME[p], p));
+        }
+
+        void charge(int p, int used) { VRUNTIME[p] += static_cast<long long>(used) * 1024 / weight(PROCS.PRIORITY[p]); }
+        void preempt(int p, int tick) { TREE.insert(make_pair(VRUNTIME[p], p)); }
+        bool empty() const { return TREE.empty(); }
+        long long steals() const { return 0; }
+
+        int pick(int core, bool fill) {
+            if (TREE.empty()) return -1;
+            int p = TREE.begin()->second;
+            if (TREE.begin()->first > MIN_VRUNTIME) MIN_VRUNTIME = TREE.begin()->first;
+            TREE.erase(TREE.begin());
+            return p;
+        }
+};
+
+// per-core run queues: every core owns a queue (a FIFO per priority, highest first) and runs
+// what is on it, so nothing is shared between cores on the common path.  a process that used up
+// its quantum or woke from io goes back on the queue of the core it last ran on; a new one goes
+// on the least loaded core, within its priority's reserved cores if reserve is set.  a core
+// with nothing of its own steals from the peer with the longest queue, and the stolen process
+// is its own from then on, so the only migrations are steals (verify mode checks exactly
+// that).  queue lengths are kept in an ordered set, so finding the least or most loaded core
+// is O(log cores)
+class PerCorePolicy {
+    private:
+        ProcessTable& PROCS;
+        bool RESERVE;
+        int BOUNDS[4]; // first core reserved for each priority, then the core count
+        vector<queue<int>> LOCAL; // run queue of each core, one FIFO per priority: core c's are LOCAL[3c] to LOCAL[3c + 2]
+        vector<int> LENGTH; // processes on each core's queue
+        set<pair<int, int>> LOAD; // (queue length, core) of every core
+        set<pair<int, int>> RANGE_LOAD[3]; // the same for the cores reserved for each priority
+        vector<int> RANGE; // priority range each core is in
+        int WAITING; // processes on all queues
+        long long STEALS;
+
+        // change the queue length of core, keeping both load sets in order
+        void resize(int core, int delta) {
+            set<pair<int, int>>& range = RANGE_LOAD[RANGE[core]];
+            LOAD.erase(make_pair(LENGTH[core], core));
+            range.erase(make_pair(LENGTH[core], core));
+            LENGTH[core] += delta;
+            LOAD.insert(make_pair(LENGTH[core], core));
+            range.insert(make_pair(LENGTH[core], core));
+            WAITING += delta;
+        }
+
+        void push(int core, int p) {
+            LOCAL[3 * core + PROCS.PRIORITY[p] - 1].push(p);
+            resize(core, 1);
+        }
+
+        int pop(int core) {
+            int q = 3 * core;
+            while (LOCAL[q].empty()) q++;
+            int p = LOCAL[q].front();
+            LOCAL[q].pop();
+            resize(core, -1);
+            return p;
+        }
+
+    public:
+        PerCorePolicy(ProcessTable& procs, const SimConfig& config, bool reserve)
+            : PROCS(procs), RESERVE(reserve), LOCAL(3 * config.cores), LENGTH(config.cores, 0), RANGE(config.cores), WAITING(0), STEALS(0) {
+            int high = SimConfig::high_reserved(config.cores), medium = SimConfig::medium_reserved(config.cores);
+            BOUNDS[0] = 0;
+            BOUNDS[1] = high;
+            BOUNDS[2] = high + medium;
+            BOUNDS[3] = config.cores;
+            for (int c = 0; c < config.cores; c++) {
+                RANGE[c] = c < BOUNDS[1] ? 0 : c < BOUNDS[2] ? 1 : 2;
+                LOAD.insert(make_pair(0, c));
+                RANGE_LOAD[RANGE[c]].insert(make_pair(0, c));
+            }
+        };
+
+        void admit(int p) {}
+
+        // back to the core it last ran on, which is where a steal or affinity left it
+        void enqueue(int p, int tick) {
+            int core = PROCS.LAST_CORE[p];
+            if (core < 0) {
+                // new process: least loaded core it may go on
+                const set<pair<int, int>>& range = RANGE_LOAD[PROCS.PRIORITY[p] - 1];
+                // no cores reserved for this priority: any core
+                core = RESERVE && !range.empty() ? range.begin()->second : LOAD.begin()->second;
+            }
+            push(core, p);
+        }
+
+        void charge(int p, int used) {}
+        void preempt(int p, int tick) { push(PROCS.LAST_CORE[p], p); }
+        bool empty() const { return WAITING == 0; }
+        long long steals() const { return STEALS; }
+
+        int pick(int core, bool fill) {
+            if (LENGTH[core] > 0) return pop(core);
+            if (!fill) return -1;
+            // nothing local: steal from the busiest peer
+            int victim = LOAD.rbegin()->second;
+            if (LENGTH[victim] == 0) return -1;
+            STEALS++;
+            return pop(victim);
+        }
+};
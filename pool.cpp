@@ -0,0 +1,137 @@
+#pragma once
+#include "pcb.cpp"
+#include "histogram.cpp"
+#include <vector>
+
+///////////////////////////////////////////////////
+///// RECYCLED PROCESS POOL ///////////////////////
+///////////////////////////////////////////////////
+
+// totals over the processes that left the system during one window step
+struct WindowBucket {
+    long long processes = 0;
+    long long cpu_bursts = 0;
+    long long turnaround = 0;
+    long long wait = 0;
+    long long response = 0;
+};
+
+// process table for sources that hand out processes as they arrive and take them back when
+// they are done (streamed traces, open-system runs).  only the processes in the system have
+// a row: finished rows go on a free list and are handed to the next arrival, so the table
+// is sized by the most processes ever in the system at once rather than by how many pass
+// through.  every row has room for STRIDE bursts; a process with more makes the table relay
+// itself out with a wider stride.  results are folded into running totals and histograms
+// (and per window step, if asked for) as each process is released
+class ProcessPool {
+    private:
+        Arena ARENAS[2]; // the table lives in ARENAS[LIVE], the other one takes the copy when it grows
+        int LIVE;
+        ProcessTable TABLE;
+        ProcessTable::WorkloadColumns COLUMNS; // writable handles on the workload columns of TABLE
+        int STRIDE; // bursts each row has room for
+        vector<int> FREE; // rows not holding a process, next one to hand out at the back
+        int WINDOW_STEP; // ms per window bucket, 0 if windows are not tracked
+        vector<WindowBucket> BUCKETS;
+
+        // copy the table into one with room for rows processes of up to stride bursts each
+        void relayout(int rows, int stride) {
+            Arena& fresh = ARENAS[1 - LIVE];
+            fresh.reset();
+            ProcessTable grown;
+            ProcessTable::WorkloadColumns columns = grown.allocate(fresh, rows, static_cast<long long>(rows) * stride);
+            for (int i = 0; i < TABLE.count; i++) {
+                columns.pid[i] = TABLE.PID[i];
+                columns.arrival[i] = TABLE.ARRIVAL[i];
+                columns.priority[i] = TABLE.PRIORITY[i];
+                int offset = i * stride;
+                columns.cpu_begin[i] = offset;
+                for (int b = TABLE.CPU_BEGIN[i]; b < TABLE.CPU_END[i]; b++) columns.bursts[offset++] = TABLE.BURSTS[b];
+                columns.cpu_end[i] = columns.io_begin[i] = offset;
+                for (int b = TABLE.IO_BEGIN[i]; b < TABLE.IO_END[i]; b++) columns.bursts[offset++] = TABLE.BURSTS[b];
+                columns.io_end[i] = offset;
+                grown.STATE[i] = TABLE.STATE[i];
+                grown.TURNAROUND[i] = TABLE.TURNAROUND[i];
+                grown.WAIT[i] = TABLE.WAIT[i];
+                grown.RESPONSE[i] = TABLE.RESPONSE[i];
+                grown.CPU_NEXT[i] = columns.cpu_begin[i] + (TABLE.CPU_NEXT[i] - TABLE.CPU_BEGIN[i]);
+                grown.CPU_LEFT[i] = TABLE.CPU_LEFT[i];
+                grown.IO_NEXT[i] = columns.io_begin[i] + (TABLE.IO_NEXT[i] - TABLE.IO_BEGIN[i]);
+                grown.IO_LEFT[i] = TABLE.IO_LEFT[i];
+                grown.FIRST_DISPATCH[i] = TABLE.FIRST_DISPATCH[i];
+                grown.FINISH[i] = TABLE.FINISH[i];
+                grown.LAST_CORE[i] = TABLE.LAST_CORE[i];
+                grown.MIGRATIONS[i] = TABLE.MIGRATIONS[i];
+                grown.SWITCHES[i] = TABLE.SWITCHES[i];
+            }
+            for (int i = rows - 1; i >= TABLE.count; i--) FREE.push_back(i);
+            TABLE = grown;
+            COLUMNS = columns;
+            STRIDE = stride;
+            LIVE = 1 - LIVE;
+        }
+
+    public:
+        // totals over every process that has left the system
+        long long processes = 0;
+        long long tot_turnaround = 0;
+        long long tot_wait = 0;
+        long long tot_response = 0;
+        LatencyHistograms latency;
+        int active = 0; // processes in the system right now
+        int peak_active = 0; // most processes in the system at once
+        vector<ProcessRecord> * accounting = nullptr; // where each process's record goes as it leaves, if anywhere
+
+        ProcessPool(int stride) : LIVE(0), STRIDE(stride), WINDOW_STEP(0) { relayout(64, stride); };
+        ProcessPool(const ProcessPool&) = delete;
+        ProcessPool& operator=(const ProcessPool&) = delete;
+
+        ProcessTable& table() { return TABLE; }
+
+        // also keep totals per step ms of simulated time, by the time each process leaves
+        void track_windows(int step) { WINDOW_STEP = step; }
+        const vector<WindowBucket>& windows() const { return BUCKETS; }
+        int window_step() const { return WINDOW_STEP; }
+
+        // put a process in a free row.  bursts alternate cpu, io, cpu, ... starting with a cpu burst
+        int add(int pid, int arrival, int priority, const int * bursts, int count) {
+            if (count > STRIDE) relayout(TABLE.count, max(count, 2 * STRIDE));
+            if (FREE.empty()) relayout(2 * TABLE.count, STRIDE);
+            int row = FREE.back();
+            FREE.pop_back();
+            COLUMNS.pid[row] = pid;
+            COLUMNS.arrival[row] = arrival;
+            COLUMNS.priority[row] = priority;
+            COLUMNS.cpu_begin[row] = COLUMNS.cpu_end[row] = row * STRIDE;
+            COLUMNS.io_begin[row] = COLUMNS.io_end[row] = row * STRIDE + (count + 1) / 2;
+            for (int j = 0; j < count; j++) {
+                if (j%2) COLUMNS.bursts[COLUMNS.io_end[row]++] = bursts[j];
+                else COLUMNS.bursts[COLUMNS.cpu_end[row]++] = bursts[j];
+            }
+            active++;
+            if (active > peak_active) peak_active = active;
+            return row;
+        }
+
+        // the process in row left the system at time ms, with its results final
+        void release(int row, long long time) {
+            processes++;
+            tot_turnaround += TABLE.TURNAROUND[row];
+            tot_wait += TABLE.WAIT[row];
+            tot_response += TABLE.RESPONSE[row];
+            latency.add(TABLE.TURNAROUND[row], TABLE.WAIT[row], TABLE.RESPONSE[row]);
+            if (accounting != nullptr) accounting->push_back(TABLE.record(row));
+            if (WINDOW_STEP > 0) {
+                size_t step = time / WINDOW_STEP;
+                if (step >= BUCKETS.size()) BUCKETS.resize(step + 1);
+                WindowBucket& bucket = BUCKETS[step];
+                bucket.processes++;
+                bucket.cpu_bursts += TABLE.CPU_END[row] - TABLE.CPU_BEGIN[row];
+                bucket.turnaround += TABLE.TURNAROUND[row];
+                bucket.wait += TABLE.WAIT[row];
+                bucket.response += TABLE.RESPONSE[row];
+            }
+            active--;
+            FREE.push_back(row);
+        }
+};
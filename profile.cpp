@@ -0,0 +1,283 @@
+#pragma once
+#include <cstdlib>
+#include <new>
+using namespace std;
+
+///////////////////////////////////////////////////
+///// SELF PROFILING //////////////////////////////
+///////////////////////////////////////////////////
+
+// where the simulator's own time goes, by phase: workload generation and parsing, and inside
+// the engines the arrivals, the pass over the running processes, dispatch and io.  built in
+// only with -DSIMPROFILE=1 (or 2, which adds perf markers); otherwise every PROFILE_ macro
+// is empty and nothing here is compiled.  each thread counts into its own counters with no
+// locking: per phase the ticks spent in it (rdtsc on x86, steady_clock ns elsewhere), how
+// often it was entered and how many heap and arena blocks were allocated while it was the
+// innermost phase.  a nested phase's time counts for it alone, so "engine" is what is left of
+// an engine call outside the engine phases (set up, the event queue, the end of run checks).
+// the command line hands the counters to the log after every run (PROFILE_COLLECT), and the
+// log writes them to profile.csv at exit, per run and in total
+//
+// the engine phases are far too short to time every one: two clock reads per phase doubled
+// the run time.  so inside an engine the time is sampled by pass.  the engines mark the start
+// of every pass (PROFILE_PASS: a tick engine pass, an event engine tick) and only one pass in
+// PROFILE_SAMPLE is timed, counting for PROFILE_SAMPLE times what it took.  entries and
+// allocations are still counted on every pass, and the time outside the engines is all taken
+//
+// with SIMPROFILE=2 every phase entry and exit also calls sim_phase_mark(phase, begin), an
+// empty function that is never inlined, so perf can put a user probe on it:
+//     perf probe -x ./simulation 'sim_phase_mark phase begin'
+//     perf record -e probe_simulation:sim_phase_mark -g ./simulation ...
+
+#ifndef SIMPROFILE
+#define SIMPROFILE 0
+#endif
+
+const int PROFILE_SAMPLE = 16; // one engine pass in this many is timed
+const int PROFILE_DEPTH = 16; // phases nested deeper than this count for the one at this depth
+
+enum ProfilePhase {
+    PH_GENERATE = 0, // gen_workload
+    PH_PARSE = 1, // text workloads and trace lines
+    PH_ENGINE = 2, // an engine call, outside the phases below
+    PH_ARRIVALS = 3, // processes joining the ready queues
+    PH_RUNNING = 4, // quanta ending on the cores
+    PH_DISPATCH = 5, // ready processes loaded onto cores
+    PH_IO = 6, // io bursts served and finished
+    PH_SUMMARY = 7, // per-run totals and latency histograms
+    PHASES = 8
+};
+
+#if SIMPROFILE
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <utility>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+inline const char * phase_name(int phase) {
+    static const char * names[PHASES] = {"generate", "parse", "engine", "arrivals", "running", "dispatch", "io", "summary"};
+    return names[phase];
+}
+
+inline unsigned long long profile_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+struct PhaseCounters {
+    unsigned long long ticks[PHASES];
+    long long calls[PHASES];
+    long long allocations[PHASES];
+    int stack[PROFILE_DEPTH]; // phases the thread is in, innermost last
+    int depth; // may be past PROFILE_DEPTH
+    unsigned long long since; // when the innermost phase was last entered or resumed
+    long long passes; // engine passes started
+    bool sampling; // in an engine, past its first pass
+    bool skipping; // in an engine pass that is not timed
+
+    int innermost() const { return stack[(depth < PROFILE_DEPTH ? depth : PROFILE_DEPTH) - 1]; }
+
+    void add(const PhaseCounters& other) {
+        for (int p = 0; p < PHASES; p++) {
+            ticks[p] += other.ticks[p];
+            calls[p] += other.calls[p];
+            allocations[p] += other.allocations[p];
+        }
+    }
+    // the counts cleared, the phases the thread is in kept
+    void clear() {
+        for (int p = 0; p < PHASES; p++) ticks[p] = calls[p] = allocations[p] = 0;
+    }
+};
+
+// zero-initialized and trivially constructed, so operator new can count into it on any thread
+static thread_local PhaseCounters profile_counters;
+
+extern "C" __attribute__((noinline)) void sim_phase_mark(int phase, int begin) {
+    asm volatile("" : : "r"(phase), "r"(begin) : "memory"); // keeps the call and its arguments
+}
+
+// the time since the last clock read to the innermost phase, scaled up in a sampled pass
+inline void profile_charge(PhaseCounters& c, unsigned long long now) {
+    if (c.skipping || c.depth == 0) return;
+    c.ticks[c.innermost()] += (now - c.since) * (c.sampling ? PROFILE_SAMPLE : 1);
+}
+
+// phases nest, and the time of a nested phase is taken out of the one around it, so the
+// phases add up to the time spent in any of them
+inline void profile_enter(int phase) {
+    if (SIMPROFILE >= 2) sim_phase_mark(phase, 1);
+    PhaseCounters& c = profile_counters;
+    if (!c.skipping) {
+        unsigned long long now = profile_ticks();
+        profile_charge(c, now);
+        c.since = now;
+    }
+    if (c.depth < PROFILE_DEPTH) c.stack[c.depth] = phase;
+    c.depth++;
+    c.calls[phase]++;
+}
+inline void profile_leave() {
+    PhaseCounters& c = profile_counters;
+    int phase = c.innermost();
+    if (!c.skipping) {
+        unsigned long long now = profile_ticks();
+        profile_charge(c, now);
+        c.since = now;
+    }
+    c.depth--;
+    if (phase == PH_ENGINE && c.sampling) {
+        // out of the engine every phase is timed again
+        if (c.skipping) c.since = profile_ticks();
+        c.sampling = c.skipping = false;
+    }
+    if (SIMPROFILE >= 2) sim_phase_mark(phase, 0);
+}
+
+// the start of an engine pass: the clock is only read where timing starts or stops
+inline void profile_pass() {
+    PhaseCounters& c = profile_counters;
+    bool skip = ++c.passes % PROFILE_SAMPLE != 0;
+    if (c.sampling && skip == c.skipping) return;
+    unsigned long long now = profile_ticks();
+    profile_charge(c, now);
+    c.since = now;
+    c.sampling = true;
+    c.skipping = skip;
+}
+
+// a phase from construction to the end of the scope
+class ProfileScope {
+    public:
+        ProfileScope(int phase) { profile_enter(phase); };
+        ~ProfileScope() { profile_leave(); }
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+inline void profile_allocation() {
+    PhaseCounters& c = profile_counters;
+    if (c.depth > 0) c.allocations[c.innermost()]++;
+}
+
+// every thread's counters, keyed by the runs they cover: (first run, run count), or (-1, 0)
+// for work outside any run.  written out when the program exits
+class ProfileLog {
+    private:
+        mutex LOCK;
+        map<pair<int, int>, PhaseCounters> RUNS;
+
+    public:
+        // move this thread's counters since the last collect into the entry of these runs
+        void collect(int first, int count) {
+            PhaseCounters& mine = profile_counters;
+            lock_guard<mutex> hold(LOCK);
+            map<pair<int, int>, PhaseCounters>::iterator it = RUNS.find(make_pair(first, count));
+            if (it == RUNS.end()) {
+                it = RUNS.insert(make_pair(make_pair(first, count), PhaseCounters())).first;
+                it->second.clear();
+            }
+            it->second.add(mine);
+            mine.clear();
+        }
+
+        ~ProfileLog() {
+            collect(-1, 0); // whatever the main thread did last
+            ofstream out("profile.csv");
+            if (!out.is_open()) { cerr << "Error opening profile.csv.\n"; return; }
+            PhaseCounters total;
+            total.clear();
+            // a line per run and phase, so no flush per line
+            out << "runs,phase,ticks,calls,allocations,ticks_per_call\n";
+            // formatted by hand: a big campaign has a line per run and phase, and ostream (or
+            // snprintf) took longer over them than the profiled runs
+            auto number = [](char * at, unsigned long long value) {
+                char digits[20];
+                int n = 0;
+                do { digits[n++] = '0' + value % 10; value /= 10; } while (value > 0);
+                *at++ = ',';
+                while (n > 0) *at++ = digits[--n];
+                return at;
+            };
+            auto write = [&](const string& runs, const PhaseCounters& c) {
+                char line[160];
+                for (int p = 0; p < PHASES; p++) {
+                    if (c.calls[p] == 0 && c.allocations[p] == 0) continue;
+                    char * at = line;
+                    *at++ = ',';
+                    for (const char * name = phase_name(p); *name; name++) *at++ = *name;
+                    at = number(at, c.ticks[p]);
+                    at = number(at, c.calls[p]);
+                    at = number(at, c.allocations[p]);
+                    at = number(at, c.calls[p] > 0 ? c.ticks[p] / c.calls[p] : 0);
+                    *at++ = '\n';
+                    out.write(runs.data(), runs.size());
+                    out.write(line, at - line);
+                }
+            };
+            for (map<pair<int, int>, PhaseCounters>::iterator it = RUNS.begin(); it != RUNS.end(); it++) {
+                const pair<int, int>& runs = it->first;
+                // run numbers count from 1, as in results.txt
+                if (runs.first < 0) write("none", it->second);
+                else if (runs.second == 1) write(to_string(runs.first + 1), it->second);
+                else write(to_string(runs.first + 1) + "-" + to_string(runs.first + runs.second), it->second);
+                total.add(it->second);
+            }
+            write("total", total);
+
+            // the totals as shares of all the time profiled
+            unsigned long long all = 0;
+            for (int p = 0; p < PHASES; p++) all += total.ticks[p];
+            cerr << "Profile (written to profile.csv):\n";
+            for (int p = 0; p < PHASES; p++) {
+                if (total.calls[p] == 0) continue;
+                cerr << "  " << phase_name(p) << ": " << total.ticks[p] << " ticks (" << (all > 0 ? 100 * total.ticks[p] / all : 0) << "%), ";
+                cerr << total.calls[p] << " calls, " << total.allocations[p] << " allocations\n";
+            }
+        }
+};
+
+inline ProfileLog& profile_log() {
+    static ProfileLog log;
+    return log;
+}
+
+// heap allocations of the whole program go through here, so each one lands on a phase.  not
+// inlined, or gcc takes the free() for a mismatch with the new
+__attribute__((noinline)) void * operator new(size_t size) {
+    profile_allocation();
+    void * p = malloc(size ? size : 1);
+    if (p == nullptr) throw bad_alloc();
+    return p;
+}
+__attribute__((noinline)) void operator delete(void * p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void * p, size_t) noexcept { free(p); }
+
+#define PROFILE_JOIN2(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN2(a, b)
+#define PROFILE_PHASE(phase) ProfileScope PROFILE_JOIN(profile_scope_, __LINE__)(phase)
+#define PROFILE_ENTER(phase) profile_enter(phase)
+#define PROFILE_LEAVE() profile_leave()
+#define PROFILE_PASS() profile_pass()
+#define PROFILE_ALLOCATION() profile_allocation()
+#define PROFILE_COLLECT(first, count) profile_log().collect(first, count)
+
+#else
+
+#define PROFILE_PHASE(phase)
+#define PROFILE_ENTER(phase)
+#define PROFILE_LEAVE()
+#define PROFILE_PASS()
+#define PROFILE_ALLOCATION()
+#define PROFILE_COLLECT(first, count)
+
+#endif
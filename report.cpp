@@ -0,0 +1,177 @@
+#pragma once
+#include "simulator.cpp"
+#include <iomanip>
+#include <iostream>
+
+#ifndef PRINTMODE
+#define PRINTMODE false // used for whether or not to print outeach sim run's results
+#endif
+
+///////////////////////////////////////////////////
+///// RESULTS /////////////////////////////////////
+///////////////////////////////////////////////////
+
+// results.txt and the latency file, shared by the simulation itself and by merge_results,
+// which has to write them exactly as a single invocation would
+
+// what verify mode found wrong with a run it flagged
+string verify_failure(const string& policy) {
+    if (policy == "percore") return "percore policy migrated a process it did not steal";
+    return "event engine does not match tick engine";
+}
+
+// the averages over every run in results (in run order) and the percentiles of latency,
+// under heading.  runs verify mode flagged are reported on cerr as failure; returns how many
+// there were
+int write_results(ostream& output, const string& heading, const vector<SimMetrics>& results, const LatencyHistograms& latency,
+                  const SimConfig& config, const IoConfig& io, const string& failure) {
+    int runcount = results.size();
+    // using our averages, show average over x runs
+    // add up and average the througputs and average statistics, always in run order
+    int mismatches = 0; // runs where the engines disagreed in verify mode
+    long long srttot = 0;
+    double thrtot = 0.0;
+    long long turavgtot = 0;
+    long long waiavgtot = 0;
+    long long resavgtot = 0;
+    long long coridltot = 0;
+    long long cpuidltot = 0;
+    long long migtot = 0;
+    long long swtot = 0;
+    long long swtimetot = 0;
+    long long migtimetot = 0;
+    double miglosstot = 0;
+    long long steatot = 0;
+    double ioutiltot = 0.0; // over all io devices
+    double iodepthtot = 0.0;
+    double iopeaktot = 0.0;
+    vector<double> devutiltot(io.devices, 0.0); // per io device
+    vector<double> devdepthtot(io.devices, 0.0);
+    vector<double> devpeaktot(io.devices, 0.0);
+    for (int simrun = 0; simrun < runcount; simrun++)  {
+        const SimMetrics& run = results[simrun];
+        if (run.mismatch) {
+            cerr << "Simulation " << simrun + 1 << ": " << failure << ".\n";
+            mismatches++;
+        }
+        if (PRINTMODE) {
+            // print analytics from this simulation run
+            // update simruntime information
+            output << "Simulation " << simrun + 1 << ": ";
+            output << "Sim run time: " << run.simruntime << endl;
+
+            // print throughput information
+            output << "Simulation " << simrun + 1 << ": ";
+            output << "Average throughput: " << run.throughput << endl;
+
+            // update turnaround information
+            output << "Simulation " << simrun + 1 << ": ";
+            output << "Average turnaround: " << run.turnaround_average << endl;
+
+            // update wait time information
+            output << "Simulation " << simrun + 1 << ": ";
+            output << "Average wait time: " << run.wait_average << endl;
+
+            // update response time information
+            output << "Simulation " << simrun + 1 << ": ";
+            output << "Average response time: " << run.response_average << endl;
+
+            // update cpu idle time information
+            output << "Simulation " << simrun + 1 << ": ";
+            output << "Total Core Idle Time: " << run.core_idle  << endl;
+            output << "Simulation " << simrun + 1 << ": ";
+            output << "Total CPU Idle Time: " << run.cpu_idle  << endl;
+            output << endl;
+        }
+        srttot += run.simruntime;
+        thrtot += run.throughput;
+        turavgtot += run.turnaround_average;
+        waiavgtot += run.wait_average;
+        resavgtot += run.response_average;
+        coridltot += run.core_idle;
+        cpuidltot += run.cpu_idle;
+        migtot += run.migrations;
+        swtot += run.switches;
+        swtimetot += run.switch_time;
+        migtimetot += run.migration_time;
+        // share of the core time handed out in quanta that went to warming caches back up
+        if (run.dispatches > 0) miglosstot += static_cast<double>(run.migration_time) / (static_cast<double>(run.dispatches) * config.rrtime);
+        steatot += run.steals;
+        // utilization is the share of the run each channel was serving, queue depth the
+        // average number of bursts queued over the run
+        long long busy = 0, queued = 0;
+        int peak = 0;
+        for (int d = 0; d < run.io.size(); d++) {
+            const IoDeviceStats& device = run.io[d];
+            busy += device.busy;
+            queued += device.queued;
+            peak = max(peak, device.peak_queue);
+            devutiltot[d] += static_cast<double>(device.busy) / (static_cast<double>(io.channels) * run.simruntime);
+            devdepthtot[d] += static_cast<double>(device.queued) / run.simruntime;
+            devpeaktot[d] += device.peak_queue;
+        }
+        ioutiltot += static_cast<double>(busy) / (static_cast<double>(io.devices) * io.channels * run.simruntime);
+        iodepthtot += static_cast<double>(queued) / run.simruntime;
+        iopeaktot += peak;
+    }
+
+    output << heading;
+    output << "Average sim run time: " << srttot / runcount << endl;
+    output << "Average throughput (processes/ms): " << std::setprecision(2) << thrtot / runcount << endl;
+    output << "Average turnaround time: " << turavgtot / runcount << endl;
+    output << "Average wait time: " << waiavgtot / runcount << endl;
+    output << "Average response time: " << resavgtot / runcount << endl;
+    output << "Average core idle time: " << coridltot / runcount << endl;
+    output << "Average cpu idle time: " << cpuidltot / runcount << endl;
+    output << "Average migrations: " << migtot / runcount << endl;
+    output << "Average context switches: " << swtot / runcount << endl;
+    if (config.switchcost > 0 || config.migrationcost > 0) {
+        output << "Average time lost to context switches (ms): " << swtimetot / runcount << endl;
+        output << "Average time lost to migrations (ms): " << migtimetot / runcount << endl;
+        output << "Core time lost to migrations (%): " << 100 * miglosstot / runcount << endl;
+    }
+    output << "Average steals: " << steatot / runcount << endl;
+    output << "Average IO utilization (%): " << 100 * ioutiltot / runcount << endl;
+    output << "Average IO queue depth: " << iodepthtot / runcount << endl;
+    output << "Average peak IO queue depth: " << iopeaktot / runcount << endl;
+    if (io.devices > 1) {
+        for (int d = 0; d < io.devices; d++) {
+            output << "IO device " << d << ": utilization (%) " << 100 * devutiltot[d] / runcount;
+            output << ", queue depth " << devdepthtot[d] / runcount;
+            output << ", peak queue depth " << devpeaktot[d] / runcount << endl;
+        }
+    }
+    output << "Turnaround p50 / p90 / p99 / p99.9: " << latency.turnaround.percentile(0.5) << " / " << latency.turnaround.percentile(0.9);
+    output << " / " << latency.turnaround.percentile(0.99) << " / " << latency.turnaround.percentile(0.999) << endl;
+    output << "Wait p50 / p90 / p99 / p99.9: " << latency.wait.percentile(0.5) << " / " << latency.wait.percentile(0.9);
+    output << " / " << latency.wait.percentile(0.99) << " / " << latency.wait.percentile(0.999) << endl;
+    output << "Response p50 / p90 / p99 / p99.9: " << latency.response.percentile(0.5) << " / " << latency.response.percentile(0.9);
+    output << " / " << latency.response.percentile(0.99) << " / " << latency.response.percentile(0.999) << endl;
+    return mismatches;
+}
+
+// percentiles of every latency distribution, as csv (a header line and a line per metric)
+// or as a json object keyed by metric
+void write_latency(ostream& output, const LatencyHistograms& latency, bool json) {
+    const char * names[3] = {"turnaround", "wait", "response"};
+    const Histogram * metrics[3] = {&latency.turnaround, &latency.wait, &latency.response};
+    const double quantiles[4] = {0.5, 0.9, 0.99, 0.999};
+    const char * labels[4] = {"p50", "p90", "p99", "p99.9"};
+    output << std::fixed << std::setprecision(2);
+    if (json) output << "{" << endl;
+    else output << "metric,count,mean,min,p50,p90,p99,p99.9,max" << endl;
+    for (int m = 0; m < 3; m++) {
+        const Histogram& h = *metrics[m];
+        if (json) {
+            output << "  \"" << names[m] << "\": {\"count\": " << h.count << ", \"mean\": " << h.mean();
+            output << ", \"min\": " << (h.count > 0 ? h.min : 0);
+            for (int q = 0; q < 4; q++) output << ", \"" << labels[q] << "\": " << h.percentile(quantiles[q]);
+            output << ", \"max\": " << h.max << "}" << (m < 2 ? "," : "") << endl;
+        } else {
+            output << names[m] << "," << h.count << "," << h.mean() << "," << (h.count > 0 ? h.min : 0);
+            for (int q = 0; q < 4; q++) output << "," << h.percentile(quantiles[q]);
+            output << "," << h.max << endl;
+        }
+    }
+    if (json) output << "}" << endl;
+}
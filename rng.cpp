@@ -0,0 +1,47 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+///////////////////////////////////////////////////
+///// RANDOM NUMBER STREAMS ///////////////////////
+///////////////////////////////////////////////////
+
+// splitmix64 generator.  every simulation run gets its own stream derived from the
+// master seed and the run number, so a run draws the same workload no matter which
+// thread picks it up or how many threads there are
+class Rng {
+    private:
+        uint64_t STATE;
+
+        // splitmix64 output function, also used to spread seeds apart
+        static uint64_t mix(uint64_t z) {
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+    public:
+        Rng(uint64_t seed) : STATE(seed) {};
+        // stream for one run of a seeded campaign
+        Rng(uint64_t master_seed, uint64_t stream) : STATE(mix(master_seed ^ mix(stream + 0x9E3779B97F4A7C15ULL))) {};
+
+        uint64_t next() {
+            STATE += 0x9E3779B97F4A7C15ULL;
+            return mix(STATE);
+        }
+
+        // uniform value in [0, bound), drop-in for rand() % bound
+        int below(int bound) {
+            return static_cast<int>(((next() >> 32) * static_cast<uint64_t>(bound)) >> 32);
+        }
+
+        // uniform value in [0, 1)
+        double uniform() {
+            return (next() >> 11) * (1.0 / 9007199254740992.0);
+        }
+
+        // exponentially distributed value with the given mean, the gaps of a poisson process
+        double exponential(double mean) {
+            return -log(1.0 - uniform()) * mean;
+        }
+};
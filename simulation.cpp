@@ -1,516 +1,601 @@
 #include "pcb.cpp"
+#include "rng.cpp"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
 #include <fstream>
 #include <time.h>
 #include <string>
 #include <queue>
 #include <iomanip>
+#include <memory>
 
-// tons of constants: mostly mins and maxes
-#define CORECOUNT 16
-#define HIGHRES CORECOUNT / 2 // reserved core amount for high priority processes
-#define MEDRES CORECOUNT / 3 // reserved core amount for medium priority processes
-#define LOWRES HIGHRES - MEDRES // reserved core amount for low priority processes
-#define PROCMIN 50 // min number of processes per sim
-#define PROCMAX 100 // max number of processes per sim
-#define PIDMIN 30 // min pid value
-#define PIDMAX PIDMIN + (PROCMAX - PROCMIN) // max pid: defined by the minpid + (range of process count)
-#define BURSTMIN 1 // min number of bursts per process
-#define BURSTMAX 8 // max number of bursts per process
-#define CPUMIN 30 // min cpu_burst size in ms
-#define CPUMAX 60 // max cpu_burst size in ms
-#define IOMIN 5 // min io_burst size in ms
-#define IOMAX 10 // max io_burst size in ms
-#define RRTIME 40 // must be less than CPUMAX in order for RR to be effective and not default to pure FCFS
-#define RUNCOUNT 100 // number of times to run the simulation
+// the tuning parameters (core count, quantum, process and burst ranges, run count) are set at
+// run time and the constants fixed at build time live with them, see config.cpp
 #define PRINTMODE false // used for whether or not to print outeach sim run's results
 
-// define gen_processes function (found at the bottom)
-void gen_processes(vector<vector<string>>& proc_t, vector<PCB *>& proc_b);
+// the simulator itself (engines, workload generation) and the open-system sources
+#include "simulator.cpp"
+#include "trace.cpp"
+#include "steady.cpp"
+#include "report.cpp"
+#include "partial.cpp"
 
 ///////////////////////////////////////////////////
-///// MAIN SIMULATION /////////////////////////////
+///// REPORTS /////////////////////////////////////
 ///////////////////////////////////////////////////
 
-// main function for this sim program
-int main() {
-    srand(time(NULL));
-
-    // values for overall averaged analytics 
-    int simruntimes[RUNCOUNT]; // sim run times
-    double throughputs[RUNCOUNT];
-    int turnaround_averages[RUNCOUNT]; // stacking of average turnaround times
-    int wait_averages[RUNCOUNT]; // stacking of average wait times
-    int response_averages[RUNCOUNT]; // stacking of average response times 
-    int core_idle_times[RUNCOUNT]; // stacking of cit: core idle time is the total idle time accumulated over all cores
-    int cpu_idle_times[RUNCOUNT]; // stacking of cpuit: cpu idle time is the total time a core was idle 
-
-    ofstream output; // output to file
-    output.open("results.txt");
-    
-    int simrun = 0;
-    while (simrun < RUNCOUNT) {
-        // different process queues based on priority
-        queue<int> high_queue; // high priority processes get assigned to half of the available processors
-        queue<int> med_queue; // medium priority processes get assigned to a third of the available processors
-        queue<int> low_queue; // low priority processes get assigned to the remaining processors
-        queue<int> wait_queue; // queue for processes waiting on an io burst   
-
-        // PCB vector
-        vector<PCB *> proc_blocks;
-
-        // Process table
-        // in each row: pid, arrival time, assigned processor, finish time
-        vector<vector<string>> proc_table; // outer is processes, inner is process attributes
-
-        // core array, holds the PID of the process it is currently handling
-        // if -1, then no PID currently assigned
-        int cores[CORECOUNT];
-        for (int i = 0; i < CORECOUNT; i++) { cores[i] = -1; }
-        
-        // generate random bursts of processes in a .txt file and parse into PCB objects
-        // see above
-        gen_processes(proc_table, proc_blocks);
-
-        // initialize processes into their respectful queues and initialize analytic times
-        for (int i = 0; i < proc_blocks.size(); i++) {
-            if (proc_blocks[i]->getPRIORITY() == 1) {
-                high_queue.push(proc_blocks[i]->getPID()); // if a high priority process, add to high priority queue
-            } else if (proc_blocks[i]->getPRIORITY() == 2) {
-                med_queue.push(proc_blocks[i]->getPID()); // if a medium priority process, add to high priority queue
-            } else if (proc_blocks[i]->getPRIORITY() == 3) {
-                low_queue.push(proc_blocks[i]->getPID()); // if a low priority process, add to high priority queue
-            } else {
-                // should not be reached, would mean a process was given an invalid priority
-                cerr << "Invalid process priority.\n";
-            }
-            proc_blocks[i]->setTURNAROUND(0);
-            proc_blocks[i]->setWAIT(0);
-            proc_blocks[i]->setRESPONSE(0);
+// metrics over a sliding window of the given length, moved along one window step at a time.
+// each line covers the processes that left the system inside that window
+void write_windows(ostream& output, const ProcessPool& pool, int window) {
+    const vector<WindowBucket>& buckets = pool.windows();
+    int step = pool.window_step();
+    int span = window / step; // steps per window
+    WindowBucket sum;
+    for (int end = 0; end < buckets.size(); end++) {
+        // slide: take in the newest step and drop the one that fell out of the window
+        sum.processes += buckets[end].processes;
+        sum.cpu_bursts += buckets[end].cpu_bursts;
+        sum.turnaround += buckets[end].turnaround;
+        sum.wait += buckets[end].wait;
+        sum.response += buckets[end].response;
+        if (end >= span) {
+            const WindowBucket& old = buckets[end - span];
+            sum.processes -= old.processes;
+            sum.cpu_bursts -= old.cpu_bursts;
+            sum.turnaround -= old.turnaround;
+            sum.wait -= old.wait;
+            sum.response -= old.response;
         }
+        if (end < span - 1) continue; // first full window
+        long long from = static_cast<long long>(end + 1 - span) * step;
+        output << "Window " << from << " - " << from + static_cast<long long>(span) * step << " ms: ";
+        output << "processes " << sum.processes;
+        output << ", throughput " << static_cast<double>(sum.processes) / (static_cast<double>(span) * step);
+        if (sum.processes > 0) {
+            output << ", turnaround " << sum.turnaround / sum.processes;
+            output << ", wait " << sum.wait / sum.processes;
+            output << ", response " << (sum.cpu_bursts > 0 ? sum.response / sum.cpu_bursts : 0);
+        }
+        output << endl;
+    }
+}
 
-        //cout << "processes initialized\n";
-
-        // values for analytics per sim
-        int sim_simruntime = 0;
-        double sim_throughput = 0.0;
-        int sim_core_idle = 0; // core idle time is the total idle time accumulated over all cores
-        int sim_cpu_idle = 0; // cpu idle time is the total time the cpu was in an idle state (a core was idle)
-        int cpu_bursts = 0; // keep track of number of cpu bursts worked through
-
-        ///// MAIN PROCESS HANDLER /////
-
-        bool run = true;
-        while (run) {
-            // add round robin time to every process's turnaround
-            for (int i = 0; i < proc_blocks.size(); i++) {
-                if (proc_blocks[i]->getSTATE() != 4)    
-                    proc_blocks[i]->setTURNAROUND(proc_blocks[i]->getTURNAROUND() + RRTIME);
-            }
-            //cout << "turnarounds updated.\n";
-            // increment simruntime time by round robin value when no process was a finished process
-            sim_simruntime += RRTIME;
-
-            // used for calculating time of last process and adding to analysis values 
-            int final_cpu_time;
-
-            ///// CURRENT PROCESSES /////
-
-            bool idle = false; // if a core was idle, only increment cpu idle time once
-            // check each process currently in a processor
-            for (int i = 0; i < CORECOUNT; i++) {
-                if (cores[i] > 0) { // if there is a process assigned to this core
-                    // subtract round robin time, and see if process has finished.  
-                    // if so,  add CPU_TIME to PCB simruntime, remove burst from that vector
-                    // otherwise, move back into its queue type
-                    vector<int> cputimes = proc_blocks[cores[i] - PIDMIN]->getCPU_TIME();
-                    if (cputimes.empty()) break;
-
-                    int time = cputimes[0] - RRTIME;
-                    if (time <= 0) { // if process is complete
-                        // update the turnaround based on the fact that this process is complete and may not have used 
-                        // the full round robin time quantum
-                        proc_blocks[cores[i] - PIDMIN]->setTURNAROUND(proc_blocks[cores[i] - PIDMIN]->getTURNAROUND() + cputimes[0]); 
-                        // erase that process's cpu burst
-                        cputimes.erase(cputimes.begin()); 
-                        // check if process has an IO burst next
-                        if (!proc_blocks[cores[i] - PIDMIN]->getIO_TIME().empty()) {
-                            wait_queue.push(cores[i]); // add this process to the wait queue
-                            proc_blocks[cores[i] - PIDMIN]->setSTATE(2); // update process state to "waiting"
-                        } else { // if process is complete (no need to check cpu_bursts, since it will not have two in a row)
-                            proc_blocks[cores[i] - PIDMIN]->setSTATE(4); // update process state to "finished"
-                        }    
-                            
-                        // reset the PCB's cpu_time vector now that one burst is removed
-                        proc_blocks[cores[i] - PIDMIN]->setCPU_TIME(cputimes);
-                        // set final cpu_time val in case it is needed
-                        final_cpu_time = time + RRTIME;
-                        cpu_bursts++;
-                    } else { // if process is not complete
-                        // subtract necessary cpu times
-                        cputimes[0] = time;
-                        proc_blocks[cores[i] - PIDMIN]->setCPU_TIME(cputimes);
-                        // move process back into its queue based on priority type
-                        if (proc_blocks[cores[i] - PIDMIN]->getPRIORITY() == 1) {
-                            high_queue.push(cores[i]);
-                        } else if (proc_blocks[cores[i] - PIDMIN]->getPRIORITY() == 2) {
-                            med_queue.push(cores[i]);
-                        } else if (proc_blocks[cores[i] - PIDMIN]->getPRIORITY() == 3) {
-                            low_queue.push(cores[i]);
-                        } 
-                        // if priority is not one of these options, then it either was never assigned a priority or it is finished
-                        // should not reach this part of the code, but if it does throw an error
-                        else cerr << "Process priority mishandle.\n";
-                    }
-                } else { // if core not being used,  add idle time
-                    if (!idle) {    
-                        sim_cpu_idle += RRTIME;
-                        idle = true;                    
-                    }
-                    sim_core_idle += RRTIME;
-                }
-                // reset core to "available" flag
-                // all cores should be reset to available each cycle
-                cores[i] = -1;
-            }
-            
-            // cout << "current processes dealt with\n";
-
-            // increment the time spent waiting in a queue, adding to the overall response time
-            for (int i = 0; i < proc_blocks.size(); i++) {
-                if (proc_blocks[i]->getSTATE() == 1) // if waiting in a queue, add round robin time to response time
-                    proc_blocks[i]->setRESPONSE(proc_blocks[i]->getRESPONSE() + RRTIME);
-            }
-
-            ///// LOADING IN NEW PROCESSES /////
-            
-            // assign processors to new processes
-            // each of these are based on a FCFS within each queue
-            // assign half of the processors to high priority processes
-            for (int i = 0; i < HIGHRES; i++) {
-                if (!high_queue.empty()) {    
-                    cores[i] = high_queue.front(); // set the core to the first available process in the queue
-                    high_queue.pop(); // remove that process from the process queue
-                    proc_blocks[cores[i] - PIDMIN]->setSTATE(3); // update process state to "running"
-                }
-            } 
-
-            // assign one third of the processors to medium priority processes
-            for (int i = HIGHRES; i < HIGHRES + MEDRES; i++) {
-                if (!med_queue.empty()) {    
-                    cores[i] = med_queue.front(); // set the core to the first available process in the queue
-                    med_queue.pop(); // remove that process from the process queue
-                    proc_blocks[cores[i] - PIDMIN]->setSTATE(3); // update process state to "running"
-                }
-            }
-
-            // assign remaining processors to low priority processes
-            for (int i = HIGHRES + MEDRES; i < CORECOUNT; i++) {
-                if (!low_queue.empty()) {    
-                    cores[i] = low_queue.front(); // set the core to the first available process in the queue
-                    low_queue.pop(); // remove that process from the process queue
-                    proc_blocks[cores[i] - PIDMIN]->setSTATE(3); // update process state to "running"
-                }
-            }
-            
-            // after each queue has had a chance to get a core assigned, assign any remaining available processors 
-            // to the next available process in high queue, then med queue, then low queue
-            for (int i = 0; i < CORECOUNT; i++) {
-                if (cores[i] == -1) {
-                    if (!high_queue.empty()) {    
-                        cores[i] = high_queue.front(); // set the core to the first available process in the queue
-                        high_queue.pop(); // remove that process from the process queue
-                        proc_blocks[cores[i] - PIDMIN]->setSTATE(3); // update process state to "running"
-                    } else if (!med_queue.empty()) {    
-                        cores[i] = med_queue.front(); // set the core to the first available process in the queue
-                        med_queue.pop(); // remove that process from the process queue
-                        proc_blocks[cores[i] - PIDMIN]->setSTATE(3); // update process state to "running"
-                    } else if (!low_queue.empty()) {    
-                        cores[i] = low_queue.front(); // set the core to the first available process in the queue
-                        low_queue.pop(); // remove that process from the process queue
-                        proc_blocks[cores[i] - PIDMIN]->setSTATE(3); // update process state to "running"
-                    } 
-                    // if all queues empty, core stays empty and idle time will be added in next cycle (above)
-                } 
-            }
-
-            // implement SRT algorithm
-            // if a process has a remaining time less than the Round Robin time, add it to high priority
-            
-            //cout << "new processes loaded in\n";
-
-            ///// HANDLING IO BURSTS /////
-            
-            // check next IO burst up in the queue. if round robin time is sufficient, then pass back to cpu queues if applicable
-            // and properly update wait time and turnaround
-            // this is organized so that every round robin cycle, we will get exactly RRTIME's worth of io_burst time worked through
-            int totio = 0;
-            bool io_processing = true;
-            int final_io_time; // used in similar fashion to final_cpu_time, only meant for if last io_burst
-            while( io_processing ) {
-                if (!wait_queue.empty()) {
-                    // add next io burst to io time processed this round
-                    vector<int> iotimes = proc_blocks[wait_queue.front() - PIDMIN]->getIO_TIME();
-                    //cout << proc_blocks[wait_queue.front() - PIDMIN] << endl;
-                    int io_burst = iotimes[0];
-                    //if (io_burst != -1) { // for handling weird error where an io burst is -1
-                        totio += io_burst;
-                        int iorrdiff = RRTIME - totio;
-                        if (iorrdiff < 0) { // if we have used up all round robin time in io bursts (i.e. this process did not fulfill its io burst)
-                            // update process io_time to subtract the difference
-                            iotimes[0] = io_burst + iorrdiff;
-                            proc_blocks[wait_queue.front() - PIDMIN]->setIO_TIME(iotimes);
-                            // add to the wait time for all processes in the queue
-                            for (int i = 0; i < proc_blocks.size(); i ++) {
-                                if (proc_blocks[i]->getSTATE() == 2) // if this process is in the wait queue, add to its wait time
-                                    proc_blocks[i]->setWAIT(proc_blocks[i]->getWAIT() + io_burst);
-                            }
+// every process's accounting record as csv, a line per process, runs in order
+void write_accounting(ostream& output, const vector<vector<ProcessRecord>>& runs) {
+    output << "run,pid,arrival,first_dispatch,finish,last_core,migrations,switches,turnaround,wait,response" << endl;
+    for (int simrun = 0; simrun < runs.size(); simrun++) {
+        for (int i = 0; i < runs[simrun].size(); i++) {
+            const ProcessRecord& r = runs[simrun][i];
+            output << simrun + 1 << "," << r.pid << "," << r.arrival << "," << r.first_dispatch << "," << r.finish << ",";
+            output << r.last_core << "," << r.migrations << "," << r.switches << "," << r.turnaround << ",";
+            output << r.wait << "," << r.response << "\n";
+        }
+    }
+}
 
-                            io_processing = false;
-                            
-                            // update final_io_time for future reference based on final burst times
-                            final_io_time = io_burst;
-                        } else { // if we have not used up all of the wait time (i.e. this process fulfilled its io burst)
-                            if (iorrdiff == 0) io_processing = false; // if used up, pop process off and exit
-                            // add wait time to the PCB for all processes in queue
-                            for (int i = 0; i < proc_blocks.size(); i ++) {
-                                if (proc_blocks[i]->getSTATE() == 2)  // if this process is in the wait queue, add to its wait time
-                                    proc_blocks[i]->setWAIT(proc_blocks[i]->getWAIT() + io_burst);
-                            }
+///////////////////////////////////////////////////
+///// PARAMETER SWEEP /////////////////////////////
+///////////////////////////////////////////////////
 
-                            // remove the used io_burst from the PCB
-                            iotimes.erase(iotimes.begin());
-                            proc_blocks[wait_queue.front() - PIDMIN]->setIO_TIME(iotimes);
+// one swept parameter and the values it takes.  only parameters that leave the workload alone
+// can be swept, so every cell of the grid runs on the very same workloads
+struct SweepAxis {
+    string name; // cores, rrtime, switchcost, migrationcost, affinity, policy, io-devices, io-channels or io-discipline
+    vector<string> values;
+};
+
+// parse "name=v1,v2,..." into axis
+bool parse_sweep_axis(const string& arg, SweepAxis& axis) {
+    size_t eq = arg.find('=');
+    if (eq == string::npos) { cerr << "--sweep needs name=value,value,...\n"; return false; }
+    axis.name = arg.substr(0, eq);
+    if (axis.name != "cores" && axis.name != "rrtime" && axis.name != "switchcost" && axis.name != "migrationcost" &&
+        axis.name != "affinity" && axis.name != "policy" &&
+        axis.name != "io-devices" && axis.name != "io-channels" && axis.name != "io-discipline") {
+        cerr << "Cannot sweep " << axis.name << ": only cores, rrtime, switchcost, migrationcost, affinity, policy, "
+             << "io-devices, io-channels and io-discipline.\n";
+        return false;
+    }
+    for (size_t start = eq + 1; start <= arg.size(); ) {
+        size_t comma = arg.find(',', start);
+        if (comma == string::npos) comma = arg.size();
+        if (comma > start) axis.values.push_back(arg.substr(start, comma - start));
+        start = comma + 1;
+    }
+    if (axis.values.empty()) { cerr << "--sweep=" << axis.name << " has no values.\n"; return false; }
+    return true;
+}
 
-                            // if process has another cpu burst, send back to its queue
-                            if (!proc_blocks[wait_queue.front() - PIDMIN]->getCPU_TIME().empty()) {
-                                // send process back to its respective queue
-                                if (proc_blocks[wait_queue.front() - PIDMIN]->getPRIORITY() == 1) {
-                                    high_queue.push(wait_queue.front());
-                                    proc_blocks[high_queue.back() - PIDMIN]->setSTATE(1); // update state to ready
-                                } else if (proc_blocks[wait_queue.front() - PIDMIN]->getPRIORITY() == 2) {
-                                    med_queue.push(wait_queue.front());
-                                    proc_blocks[med_queue.back() - PIDMIN]->setSTATE(1); // update state to ready
-                                } else { // guaranteed to be a low-priority process, as any other value would not have made it his far
-                                    low_queue.push(wait_queue.front());
-                                    proc_blocks[low_queue.back() - PIDMIN]->setSTATE(1); // update state to ready
-                                }
-                            } else { // if no remaining cpu bursts, process is then finished (no need to check io bursts, since it will not have two in a row)
-                                proc_blocks[wait_queue.front() - PIDMIN]->setSTATE(4); // update process state to "finished"
-                            }
-                            wait_queue.pop();
-                        } 
-                    //} else wait_queue.pop();
-                } else io_processing = false;
-            }
+// setup of grid cell number cell: base with every axis set to its value for that cell, the
+// last axis varying fastest.  engine_given is whether base.engine was asked for rather than
+// the default, in which case a cell that needs the event engine is an error
+bool sweep_cell(const RunSetup& base, bool engine_given, const vector<SweepAxis>& axes, int cell, RunSetup& setup, string& label) {
+    setup = base;
+    label = "";
+    string cell_name; // every axis, for messages
+    for (int a = axes.size() - 1; a >= 0; a--) {
+        const SweepAxis& axis = axes[a];
+        const string& value = axis.values[cell % axis.values.size()];
+        cell /= axis.values.size();
+        if (a < static_cast<int>(axes.size()) - 1) label = axis.name + "=" + value + (label.empty() ? "" : ", ") + label;
+        cell_name = axis.name + "=" + value + (cell_name.empty() ? "" : ", ") + cell_name;
+        if (axis.name == "policy") setup.policy.name = value;
+        else if (axis.name == "io-devices") setup.io.devices = atoi(value.c_str());
+        else if (axis.name == "io-channels") setup.io.channels = atoi(value.c_str());
+        else if (axis.name == "io-discipline") setup.io.discipline = value;
+        else if (!setup.config.set(axis.name, value)) return false;
+    }
+    if (label.empty()) label = "-";
+    // same engine rules as a single campaign
+    if (setup.needs_event_engine()) {
+        if (engine_given && setup.engine != "event") { cerr << "Sweep cell " << cell_name << " needs the event engine.\n"; return false; }
+        setup.engine = "event";
+    }
+    return setup.valid();
+}
 
-            //cout << "io bursts handled\n";
+// run every cell of the grid over the same runcount workloads: generated once from the seed
+// (or the replayed one) and shared read-only by every cell, so differences between cells come
+// from the parameters and not from the draw.  the cells and runs are spread over the workers
+// as one pool of tasks.  writes a table per metric to output, with a row per combination of
+// every axis but the last and a column per value of the last
+bool run_sweep(const RunSetup& base, bool engine_given, const vector<SweepAxis>& axes, int runcount, int threadcount,
+               uint64_t seed, ostream& output) {
+    int cells = 1;
+    for (int a = 0; a < axes.size(); a++) cells *= axes[a].values.size();
+    vector<RunSetup> setups(cells);
+    vector<string> labels(cells);
+    for (int c = 0; c < cells; c++) {
+        if (!sweep_cell(base, engine_given, axes, c, setups[c], labels[c])) return false;
+    }
 
-            // if all queues are empty, quit
-            if (high_queue.empty() &&
-                med_queue.empty() &&
-                low_queue.empty() &&
-                wait_queue.empty())  {
-                    run = false;
-                    //cout << "Simulation Run Complete." << endl;
-                    // update with final burst time splits
-                    sim_simruntime += final_cpu_time += final_io_time;
-                }
+    // the workloads, drawn from the same streams a single campaign with this seed would use
+    Arena workload_arena;
+    vector<ProcessTable> workloads(base.replay != nullptr ? 0 : runcount);
+    for (int simrun = 0; simrun < workloads.size(); simrun++) {
+        Rng rng(seed, simrun);
+        gen_workload(workloads[simrun], workload_arena, rng, base.config, base.arrival_rate);
+    }
+    PROFILE_COLLECT(-1, 0); // shared by every run
+
+    // task t is run t % runcount of cell t / runcount.  a worker keeps the histograms of the
+    // cell it is on and folds them into the cell's when it moves on, so the locks are taken
+    // about once per cell per worker
+    vector<vector<SimMetrics>> results(cells, vector<SimMetrics>(runcount));
+    vector<LatencyHistograms> latency(cells);
+    vector<mutex> latency_locks(cells);
+    long long tasks = static_cast<long long>(cells) * runcount;
+    if (threadcount > tasks) threadcount = tasks;
+    atomic<long long> next_task(0);
+    auto worker = [&]() {
+        Simulator simulator; // set up for each cell it moves to, its memory reused throughout
+        unique_ptr<LatencyHistograms> local(new LatencyHistograms());
+        int current = -1;
+        auto flush = [&]() {
+            if (current < 0) return;
+            lock_guard<mutex> hold(latency_locks[current]);
+            latency[current].merge(*local);
+            local.reset(new LatencyHistograms());
+        };
+        for (long long t = next_task++; t < tasks; t = next_task++) {
+            int cell = t / runcount, simrun = t % runcount;
+            if (cell != current) { flush(); current = cell; simulator.configure(setups[cell]); }
+            const ProcessTable& workload = setups[cell].replay != nullptr ? *setups[cell].replay : workloads[simrun];
+            results[cell][simrun] = simulator.run(workload, local.get());
+            PROFILE_COLLECT(simrun, 1); // every cell's go at the run counts for the run
         }
-        // calculate throughput of this simulation
-        sim_throughput = static_cast<double>(proc_blocks.size()) / static_cast<double>(sim_simruntime);
-        
-        // load turnaround, wait, and response times into analysis variables
-        int tot_turnaround = 0;
-        int tot_wait = 0;
-        int tot_response = 0;
-        
-        for (int i = 0; i < proc_blocks.size(); i++) {
-            tot_turnaround += proc_blocks[i]->getTURNAROUND();
-            tot_wait += proc_blocks[i]->getWAIT();
-            tot_response += proc_blocks[i]->getRESPONSE();
+        flush();
+    };
+    vector<thread> workers;
+    for (int i = 1; i < threadcount; i++) workers.push_back(thread(worker));
+    worker();
+    for (int i = 0; i < workers.size(); i++) workers[i].join();
+
+    // per-cell values of every metric: the mean over the runs, or the percentile over every process
+    const int METRICS = 11;
+    const char * names[METRICS] = {"Average throughput (processes/ms)", "Average turnaround time", "Average wait time",
+                                   "Average response time", "Turnaround p99", "Wait p99", "Response p99",
+                                   "Average core idle time", "Average cpu idle time", "Average migrations",
+                                   "Average time lost to migrations (ms)"};
+    vector<vector<double>> values(METRICS, vector<double>(cells, 0.0));
+    for (int c = 0; c < cells; c++) {
+        for (int simrun = 0; simrun < runcount; simrun++) {
+            const SimMetrics& run = results[c][simrun];
+            values[0][c] += run.throughput / runcount;
+            values[1][c] += static_cast<double>(run.turnaround_average) / runcount;
+            values[2][c] += static_cast<double>(run.wait_average) / runcount;
+            values[3][c] += static_cast<double>(run.response_average) / runcount;
+            values[7][c] += static_cast<double>(run.core_idle) / runcount;
+            values[8][c] += static_cast<double>(run.cpu_idle) / runcount;
+            values[9][c] += static_cast<double>(run.migrations) / runcount;
+            values[10][c] += static_cast<double>(run.migration_time) / runcount;
         }
+        values[4][c] = latency[c].turnaround.percentile(0.99);
+        values[5][c] = latency[c].wait.percentile(0.99);
+        values[6][c] = latency[c].response.percentile(0.99);
+    }
 
-        // load calculated analytics into our outer containers for averaging
-        simruntimes[simrun] = sim_simruntime;
-        throughputs[simrun] = sim_throughput;
-        turnaround_averages[simrun] = tot_turnaround / proc_blocks.size();
-        response_averages[simrun] = tot_response / cpu_bursts;
-        wait_averages[simrun] = tot_wait / proc_blocks.size();
-        core_idle_times[simrun] = sim_core_idle;
-        cpu_idle_times[simrun] = sim_cpu_idle;
-
-        if (PRINTMODE) { 
-            // print and compile analytics from this simulation run    
-            // update simruntime information
-            output << "Simulation " << simrun + 1 << ": ";
-            output << "Sim run time: " << simruntimes[simrun] << endl;
-
-            // print throughput information
-            output << "Simulation " << simrun + 1 << ": ";
-            output << "Average throughput: " << throughputs[simrun] << endl;
-            
-            // update turnaround information
-            output << "Simulation " << simrun + 1 << ": ";
-            output << "Average turnaround: " << turnaround_averages[simrun] << endl;
-
-            // update wait time information
-            output << "Simulation " << simrun + 1 << ": ";
-            output << "Average wait time: " << wait_averages[simrun] << endl;
+    // tab-separated tables
+    const SweepAxis& columns = axes.back();
+    int width = columns.values.size();
+    output << " -- Sweep of " << cells << " configurations over " << runcount << " runs (seed " << seed << ") -- " << endl;
+    output << std::setprecision(6);
+    for (int m = 0; m < METRICS; m++) {
+        output << endl << names[m] << endl;
+        if (axes.size() == 1) output << "-";
+        for (int a = 0; a + 1 < axes.size(); a++) output << (a > 0 ? ", " : "") << axes[a].name;
+        for (int v = 0; v < width; v++) output << "\t" << columns.name << "=" << columns.values[v];
+        output << endl;
+        for (int row = 0; row < cells / width; row++) {
+            output << labels[row * width];
+            for (int v = 0; v < width; v++) output << "\t" << values[m][row * width + v];
+            output << endl;
+        }
+    }
+    return true;
+}
 
-            // update response time information
-            output << "Simulation " << simrun + 1 << ": ";
-            output << "Average response time: " << response_averages[simrun] << endl;
+///////////////////////////////////////////////////
+///// MAIN SIMULATION /////////////////////////////
+///////////////////////////////////////////////////
 
-            // update cpu idle time information
-            output << "Simulation " << simrun + 1 << ": ";
-            output << "Total Core Idle Time: " << sim_core_idle  << endl;
-            output << "Simulation " << simrun + 1 << ": ";
-            output << "Total CPU Idle Time: " << sim_cpu_idle  << endl;
-            output << endl; 
+// main function for this sim program
+// usage: simulation [--engine=tick|event|verify] [--runs=N] [--threads=N] [--seed=N]
+//                   [--workload=FILE] [--save-workload=FILE] [--export-text=FILE] [--trace=FILE]
+//                   [--arrival-rate=R] [--steady=MS] [--window=MS] [--window-step=MS]
+//                   [--policy=reserved|srt|mlfq|cfs|percore] [--reserve=on|off]
+//                   [--io-devices=N] [--io-channels=N] [--io-discipline=fifo|sjf|elevator]
+//                   [--latency=FILE] [--config=FILE] [--cores=N] [--rrtime=MS] [--PARAMETER=VALUE ...]
+//                   [--sweep=PARAMETER=V1,V2,... ...] [--event-trace=FILE] [--accounting=FILE]
+//                   [--shard=K/N [--partial=FILE]]
+//  --engine   tick   - fixed RRTIME step loop (default)
+//             event  - discrete-event engine, same results with cost per event instead of per tick
+//             verify - run both on every workload and report any run where they disagree.  with
+//                      --policy=percore, check instead that every migration was a steal
+//  --runs     number of simulation runs (default 100)
+//  --threads  worker threads the runs are spread over (default: one per hardware thread)
+//  --seed     master seed; run i always draws the same workload for a given seed (default: time)
+//  --workload       replay this workload file (binary or text) in every run instead of generating one
+//  --save-workload  write the workload of the first run to this file in the binary format
+//  --export-text    write the workload of the first run to this file in the text format
+//  --trace          stream this trace file (text format, arrivals in order) through the event engine
+//                   as a single run; memory follows the processes in the system, not the trace length
+//  --arrival-rate   poisson arrivals at this many processes per second instead of one per ms
+//  --steady         open-system run of this many ms with poisson arrivals (needs --arrival-rate)
+//                   through the event engine; finished processes are retired and their rows reused
+//  --window         with --trace or --steady, also report metrics over a sliding window of this many ms
+//  --window-step    how far the window slides between reports, in ms (default: a tenth of the window)
+//  --policy   reserved - priority queues with reserved core ranges, the original scheme (default)
+//             srt      - shortest remaining time first
+//             mlfq     - multilevel feedback queue
+//             cfs      - fair share by virtual runtime
+//             percore  - a run queue per core, idle cores steal from the busiest peer
+//             any policy other than reserved runs on the event engine
+//  --reserve  percore: place processes on the cores reserved for their priority (default on)
+//  --io-devices     io devices, each process does its io on device PID % N (default 1)
+//  --io-channels    bursts each io device serves at once (default 1)
+//  --io-discipline  fifo     - bursts are served in the order they were queued (default)
+//                   sjf      - shortest io burst first
+//                   elevator - the device sweeps up and down its tracks, taking the nearest burst ahead
+//                   anything but a single fifo channel runs on the event engine
+//  --latency  where to write the turnaround, wait and response percentiles of every process
+//             over all runs; json if the name ends in .json, csv otherwise (default latency.csv)
+//  --config   read tuning parameters from this file, one "name = value" per line (# starts a comment).
+//             any parameter can also be given as --name=value, which wins over the file:
+//             cores, rrtime, procmin, procmax, pidmin, burstmin, burstmax, cpumin, cpumax, iomin,
+//             iomax, runs, switchcost, migrationcost and affinity (see SimConfig in config.cpp for
+//             the defaults).  affinity=1 runs on the event engine
+//  --sweep    run every combination of these values over the same workloads and report a table
+//             per metric instead; give it once per swept parameter: cores, rrtime, switchcost,
+//             migrationcost, affinity, policy, io-devices, io-channels or io-discipline.  the last
+//             one given is the table columns
+//  --event-trace  record every dispatch, preemption, io start and end and finish to this binary
+//                 file (runs on the event engine); trace_export turns it into a chrome trace
+//  --accounting   write every process's arrival, first dispatch, finish, last core, migrations,
+//                 context switches, turnaround, wait and response to this csv file
+//  --shard    run only shard K of N of the campaign (needs --seed) and write its partial result file
+//             instead of the report; merge_results combines the shards into the report
+//  --partial  where the shard's partial result file goes (default partial-K.bin)
+int main(int argc, char * argv[]) {
+    string engine = "";
+    string policy = "reserved";
+    bool reserve = true;
+    IoConfig io;
+    int threadcount = thread::hardware_concurrency();
+    uint64_t seed = time(NULL);
+    bool seed_given = false;
+    string workload_path, save_path, export_path, trace_path;
+    string latency_path = "latency.csv";
+    string event_trace_path;
+    string accounting_path;
+    int shard = 0, shards = 0; // shard of a campaign, 0 shards for the whole of it
+    string partial_path;
+    double arrival_rate = 0;
+    int steady_ms = 0;
+    SimConfig config;
+    // the config file goes first wherever it is given, so the other arguments override it
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--config=", 9) == 0 && !config.load(argv[i] + 9)) return 1;
+    }
+    int window = 0, window_step = 0;
+    vector<SweepAxis> axes;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--engine=", 9) == 0) engine = argv[i] + 9;
+        else if (strncmp(argv[i], "--runs=", 7) == 0) { if (!config.set("runs", argv[i] + 7)) return 1; }
+        else if (strncmp(argv[i], "--config=", 9) == 0) continue;
+        else if (strncmp(argv[i], "--threads=", 10) == 0) threadcount = atoi(argv[i] + 10);
+        else if (strncmp(argv[i], "--seed=", 7) == 0) { seed = strtoull(argv[i] + 7, nullptr, 10); seed_given = true; }
+        else if (strncmp(argv[i], "--workload=", 11) == 0) workload_path = argv[i] + 11;
+        else if (strncmp(argv[i], "--save-workload=", 16) == 0) save_path = argv[i] + 16;
+        else if (strncmp(argv[i], "--export-text=", 14) == 0) export_path = argv[i] + 14;
+        else if (strncmp(argv[i], "--trace=", 8) == 0) trace_path = argv[i] + 8;
+        else if (strncmp(argv[i], "--arrival-rate=", 15) == 0) arrival_rate = atof(argv[i] + 15);
+        else if (strncmp(argv[i], "--steady=", 9) == 0) steady_ms = atoi(argv[i] + 9);
+        else if (strncmp(argv[i], "--window=", 9) == 0) window = atoi(argv[i] + 9);
+        else if (strncmp(argv[i], "--window-step=", 14) == 0) window_step = atoi(argv[i] + 14);
+        else if (strncmp(argv[i], "--policy=", 9) == 0) policy = argv[i] + 9;
+        else if (strcmp(argv[i], "--reserve=on") == 0) reserve = true;
+        else if (strcmp(argv[i], "--reserve=off") == 0) reserve = false;
+        else if (strncmp(argv[i], "--io-devices=", 13) == 0) io.devices = atoi(argv[i] + 13);
+        else if (strncmp(argv[i], "--io-channels=", 14) == 0) io.channels = atoi(argv[i] + 14);
+        else if (strncmp(argv[i], "--io-discipline=", 16) == 0) io.discipline = argv[i] + 16;
+        else if (strncmp(argv[i], "--latency=", 10) == 0) latency_path = argv[i] + 10;
+        else if (strncmp(argv[i], "--event-trace=", 14) == 0) event_trace_path = argv[i] + 14;
+        else if (strncmp(argv[i], "--accounting=", 13) == 0) accounting_path = argv[i] + 13;
+        else if (strncmp(argv[i], "--shard=", 8) == 0) {
+            if (sscanf(argv[i] + 8, "%d/%d", &shard, &shards) != 2) { cerr << "--shard takes K/N.\n"; return 1; }
         }
-        // deallocate the PCBs
-        for (int i = 0; i < proc_blocks.size(); i++) {
-            delete proc_blocks[i];
+        else if (strncmp(argv[i], "--partial=", 10) == 0) partial_path = argv[i] + 10;
+        else if (strncmp(argv[i], "--sweep=", 8) == 0) {
+            axes.push_back(SweepAxis());
+            if (!parse_sweep_axis(argv[i] + 8, axes.back())) return 1;
         }
-        simrun++;
+        else if (strncmp(argv[i], "--", 2) == 0 && strchr(argv[i], '=') != nullptr) {
+            // tuning parameter
+            string arg = argv[i] + 2;
+            size_t eq = arg.find('=');
+            if (!config.set(arg.substr(0, eq), arg.substr(eq + 1))) return 1;
+        }
+        else { cerr << "Unknown argument: " << argv[i] << endl; return 1; }
     }
-
-    // using our averages, show average over x runs
-    // add up and average the througputs and average statistics
-    int srttot = 0;
-    double thrtot = 0.0;
-    int turavgtot = 0;
-    int waiavgtot = 0;
-    int resavgtot = 0;
-    int coridltot = 0;
-    int cpuidltot = 0;
-    for (int i = 0; i < RUNCOUNT; i++)  {
-        srttot += simruntimes[i];
-        thrtot += throughputs[i];
-        turavgtot += turnaround_averages[i];
-        waiavgtot += wait_averages[i];
-        resavgtot += response_averages[i];
-        coridltot += core_idle_times[i];
-        cpuidltot += cpu_idle_times[i];
+    if (!config.valid()) return 1;
+    int runcount = config.runs;
+    bool engine_given = !engine.empty();
+    if (policy != "reserved" && policy != "srt" && policy != "mlfq" && policy != "cfs" && policy != "percore") {
+        cerr << "Unknown policy: " << policy << endl;
+        return 1;
+    }
+    // verify mode cannot compare percore with the tick engine, it checks its steals instead
+    bool verify_steals = engine == "verify" && policy == "percore";
+    if (policy != "reserved" && !verify_steals) {
+        // the tick engine only knows the reserved scheme
+        if (engine != "" && engine != "event") { cerr << "--policy=" << policy << " needs the event engine.\n"; return 1; }
+        engine = "event";
+    }
+    if (io.discipline != "fifo" && io.discipline != "sjf" && io.discipline != "elevator") {
+        cerr << "Unknown io discipline: " << io.discipline << endl;
+        return 1;
+    }
+    if (io.devices < 1 || io.channels < 1) { cerr << "--io-devices and --io-channels must be at least 1.\n"; return 1; }
+    if ((io.devices > 1 || io.channels > 1 || io.discipline != "fifo") && !verify_steals) {
+        // the tick engine only knows the single fifo device
+        if (engine != "" && engine != "event") { cerr << "More than one fifo io channel needs the event engine.\n"; return 1; }
+        engine = "event";
+    }
+    if (config.affinity != 0) {
+        // the tick engine dispatches in queue order only
+        if (engine != "" && engine != "event") { cerr << "affinity needs the event engine.\n"; return 1; }
+        engine = "event";
+    }
+    if (!event_trace_path.empty()) {
+        // only the event engine records its decisions
+        if (engine != "" && engine != "event") { cerr << "--event-trace needs the event engine.\n"; return 1; }
+        if (!axes.empty()) { cerr << "--event-trace cannot be combined with --sweep.\n"; return 1; }
+        engine = "event";
+    }
+    bool open_system = !trace_path.empty() || steady_ms > 0;
+    if (!trace_path.empty() && steady_ms > 0) { cerr << "--trace and --steady cannot be combined.\n"; return 1; }
+    if (steady_ms > 0 && arrival_rate <= 0) { cerr << "--steady needs a positive --arrival-rate.\n"; return 1; }
+    if (!workload_path.empty() && arrival_rate > 0) { cerr << "--arrival-rate cannot be combined with --workload.\n"; return 1; }
+    if (window > 0 && !open_system) { cerr << "--window needs --trace or --steady.\n"; return 1; }
+    if (open_system) {
+        // processes are streamed in, so only the event engine can take them and there is nothing to save
+        if (!workload_path.empty() || !save_path.empty() || !export_path.empty()) {
+            cerr << "--trace and --steady cannot be combined with --workload, --save-workload or --export-text.\n";
+            return 1;
+        }
+        if (engine != "" && engine != "event") { cerr << "--trace and --steady need the event engine.\n"; return 1; }
+        engine = "event";
+        runcount = 1;
+    }
+    if (!axes.empty() && (open_system || engine == "verify")) { cerr << "--sweep cannot be combined with --trace, --steady or --engine=verify.\n"; return 1; }
+    if (!axes.empty() && !accounting_path.empty()) { cerr << "--accounting cannot be combined with --sweep.\n"; return 1; }
+    if (window > 0) {
+        if (window_step <= 0) window_step = window / 10 > 0 ? window / 10 : 1;
+        if (window_step > window) window_step = window;
+        window = window / window_step * window_step; // whole steps only
+    }
+    if (engine == "") engine = "tick";
+    if (engine != "tick" && engine != "event" && engine != "verify") {
+        cerr << "Unknown engine: " << engine << endl;
+        return 1;
+    }
+    // a shard runs its share of the run numbers and leaves the report to merge_results
+    bool sharded = shards != 0;
+    int first_run = 0, last_run = runcount;
+    if (sharded) {
+        if (shards < 1 || shard < 0 || shard >= shards) { cerr << "--shard=K/N needs 0 <= K < N.\n"; return 1; }
+        if (shards > runcount) { cerr << "--shard=K/N needs at least N runs.\n"; return 1; }
+        if (!seed_given) { cerr << "--shard needs an explicit --seed, the same for every shard.\n"; return 1; }
+        if (open_system || !axes.empty()) { cerr << "--shard cannot be combined with --trace, --steady or --sweep.\n"; return 1; }
+        first_run = static_cast<long long>(runcount) * shard / shards;
+        last_run = static_cast<long long>(runcount) * (shard + 1) / shards;
+        if (partial_path.empty()) partial_path = "partial-" + to_string(shard) + ".bin";
+    } else if (!partial_path.empty()) { cerr << "--partial needs --shard.\n"; return 1; }
+    if (threadcount < 1) threadcount = 1;
+    if (axes.empty() && threadcount > last_run - first_run) threadcount = last_run - first_run;
+
+    RunSetup setup;
+    setup.config = config;
+    setup.engine = engine;
+    setup.policy.name = policy;
+    setup.policy.reserve = reserve;
+    setup.io = io;
+    setup.arrival_rate = arrival_rate;
+
+    // workload to replay, shared read-only by every run
+    WorkloadFile workload_file;
+    if (!workload_path.empty()) {
+        if (!workload_file.open(workload_path)) return 1;
+        setup.replay = &workload_file.table();
     }
-    
-    // displa info gathered
-    output << " -- Over " << RUNCOUNT << " runs -- " << endl;
-    output << "Average sim run time: " << srttot / RUNCOUNT << endl;
-    output << "Average throughput (processes/ms): " << std::setprecision(2) << thrtot / RUNCOUNT << endl;
-    output << "Average turnaround time: " << turavgtot / RUNCOUNT << endl;
-    output << "Average wait time: " << waiavgtot / RUNCOUNT << endl;
-    output << "Average response time: " << resavgtot / RUNCOUNT << endl;
-    output << "Average core idle time: " << coridltot / RUNCOUNT << endl;
-    output << "Average cpu idle time: " << cpuidltot / RUNCOUNT << endl;
-
-    output.close();
 
-    return 0;
-}
+    // persist the first run's workload if asked, generated from the same stream the run uses
+    if (!save_path.empty() || !export_path.empty()) {
+        Arena arena;
+        ProcessTable first;
+        if (setup.replay != nullptr) first = *setup.replay;
+        else { Rng rng(seed, 0); gen_workload(first, arena, rng, config, arrival_rate); }
+        if (!save_path.empty() && !save_workload_binary(first, save_path)) return 1;
+        if (!export_path.empty()) {
+            ofstream text(export_path);
+            if (!text.is_open()) { cerr << "Error opening text export file " << export_path << ".\n"; return 1; }
+            write_workload_text(first, text);
+        }
+    }
 
-///////////////////////////////////////////////////
-///// RANDOM PROCESS GENERATION AND LOADING ///////
-///////////////////////////////////////////////////
+    PROFILE_COLLECT(-1, 0); // loading and saving workloads belongs to no run
 
-// function for generating a file of random processes with bursts as well as
-// loading processes into their respective PCBs based on the processes file
-// key for this file is: PID, Arrival Time, Priority, CPU Burst, IO Burst, CPU Burst, IO Burst, etc
-void gen_processes(vector<vector<string>>& proc_t, vector<PCB *>& proc_b) {
-    
-    ///// GENERATE PROCESSES INTO A FILE /////
-    
-    // create a random number of processes
-    int num_processes = rand() % (PROCMAX - PROCMIN) + PROCMIN;
-    // create file for process info to be generated in
-    ofstream process_file;
-    try {    
-        process_file.open("processes.txt");
-    } catch(...) { cerr << "Error opening processes file.\n"; }
+    if (!axes.empty()) {
+        ofstream output("results.txt");
+        return run_sweep(setup, engine_given, axes, runcount, threadcount, seed, output) ? 0 : 1;
+    }
 
-    // fill in each line of the processes file with unique PIDs and random amounts of CPU / IO bursts
-    try {
-        for (int i = 0; i < num_processes; i++) {
-            process_file << i + PIDMIN << ", " << i << ", ";
-            // generate a random priority for this process
-            process_file << rand() % 3 + 1 << ", ";
-            // generate a random number of cpu / io bursts
-            int bursts = rand() % (BURSTMAX - BURSTMIN) + BURSTMIN;
-            for (int j = 0; j < bursts; j++) {
-                // if this will be an io burst
-                // generate random amount of time for the io burst
-                if (j%2) process_file << rand() % (IOMAX - IOMIN) + IOMIN << ", ";
-                // if this will be a cpu burst
-                else process_file << rand() % (CPUMAX - CPUMIN) + CPUMIN << ", ";
+    // where the event trace goes, each worker fills its own buffer of it
+    TraceFile event_trace;
+    bool tracing = !event_trace_path.empty();
+    if (tracing && !event_trace.open(event_trace_path, config.cores, config.rrtime)) return 1;
+
+    // values for overall averaged analytics, one slot per run
+    vector<SimMetrics> results(runcount);
+    // per-process accounting of every run, if asked for
+    bool accounting = !accounting_path.empty();
+    vector<vector<ProcessRecord>> records(accounting ? runcount : 0);
+    // per-process latency distributions over every run
+    LatencyHistograms latency;
+
+    // sources of an open-system run, and the pool its processes went through
+    unique_ptr<TraceSource> trace;
+    unique_ptr<PoissonSource> steady;
+    const ProcessPool * open_pool = nullptr;
+    unique_ptr<EventTracer> open_tracer(tracing ? new EventTracer(event_trace) : nullptr);
+    Simulator open_simulator(setup);
+    open_simulator.trace_to(open_tracer.get());
+    if (accounting) open_simulator.account_to(&records[0]);
+    if (!trace_path.empty()) {
+        trace.reset(new TraceSource(config));
+        if (window > 0) trace->pool.track_windows(window_step);
+        if (!trace->open(trace_path) || !open_simulator.run_open(*trace, results[0]) || trace->failed()) return 1;
+        PROFILE_COLLECT(0, 1);
+        open_pool = &trace->pool;
+        latency = open_pool->latency;
+    } else if (steady_ms > 0) {
+        steady.reset(new PoissonSource(Rng(seed, 0), config, arrival_rate, steady_ms));
+        if (window > 0) steady->pool.track_windows(window_step);
+        if (!open_simulator.run_open(*steady, results[0])) return 1;
+        PROFILE_COLLECT(0, 1);
+        open_pool = &steady->pool;
+        latency = open_pool->latency;
+    } else {
+        // thread pool: each worker claims the next run number until all runs are taken.
+        // the run number alone picks the random stream and the result slot, so the
+        // numbers do not depend on how many workers there are or which one ran what.
+        // each worker fills its own histograms, merged once they are all done
+        atomic<int> next_run(first_run);
+        vector<LatencyHistograms> worker_latency(threadcount);
+        auto worker = [&](int w) {
+            Simulator simulator(setup); // its memory is reused by every run this worker picks up
+            unique_ptr<EventTracer> tracer(tracing ? new EventTracer(event_trace) : nullptr);
+            simulator.trace_to(tracer.get());
+            for (int simrun = next_run++; simrun < last_run; simrun = next_run++) {
+                if (tracer) tracer->run = simrun;
+                if (accounting) simulator.account_to(&records[simrun]);
+                results[simrun] = simulator.run(Rng(seed, simrun), &worker_latency[w]);
+                PROFILE_COLLECT(simrun, 1);
             }
-            if (i < num_processes - 1) process_file << endl; // remove empty line at the end
-            // prepare the proc_table for process information to be added later
-            proc_t.push_back({""});
+        };
+        vector<thread> workers;
+        for (int i = 1; i < threadcount; i++) workers.push_back(thread(worker, i));
+        worker(0);
+        for (int i = 0; i < workers.size(); i++) workers[i].join();
+        for (int i = 0; i < threadcount; i++) latency.merge(worker_latency[i]);
+    }
+    open_tracer.reset(); // writes out whatever it still holds
+    if (tracing && !event_trace.close()) return 1;
+
+    int mismatches = 0;
+    if (sharded) {
+        // everything a merge needs to check that the shards belong together and to write the
+        // report: the parameters, then the rest of the setup
+        PartialResults partial;
+        partial.seed = seed;
+        partial.runcount = runcount;
+        partial.shard = shard;
+        partial.shards = shards;
+        partial.first_run = first_run;
+        stringstream text;
+        config.write(text);
+        text << "engine = " << engine << "\n" << "policy = " << policy << "\n" << "reserve = " << reserve << "\n";
+        text << "io-devices = " << io.devices << "\n" << "io-channels = " << io.channels << "\n";
+        text << "io-discipline = " << io.discipline << "\n" << "arrival-rate = " << arrival_rate << "\n";
+        text << "workload = " << workload_path << "\n";
+        partial.setup = text.str();
+        partial.results.assign(results.begin() + first_run, results.begin() + last_run);
+        partial.latency = latency;
+        if (!partial.save(partial_path)) return 1;
+        for (int simrun = first_run; simrun < last_run; simrun++) {
+            if (!results[simrun].mismatch) continue;
+            cerr << "Simulation " << simrun + 1 << ": " << verify_failure(policy) << ".\n";
+            mismatches++;
+        }
+    } else {
+        ofstream output; // output to file
+        output.open("results.txt");
+
+        // what the numbers cover
+        stringstream heading;
+        if (open_pool != nullptr) {
+            if (!trace_path.empty()) heading << " -- Trace " << trace_path << " -- " << endl;
+            else heading << " -- Steady state over " << steady_ms << " ms at " << arrival_rate << " arrivals/s (seed " << seed << ") -- " << endl;
+            heading << "Processes: " << open_pool->processes << endl;
+            heading << "Most processes in the system at once: " << open_pool->peak_active << endl;
+        } else {
+            heading << " -- Over " << runcount << " runs (seed " << seed << ") -- " << endl;
         }
-    } catch(...) { cerr << "Error initializing random processes in process file.\n"; }
-    process_file.close();
+        mismatches = write_results(output, heading.str(), results, latency, config, io, verify_failure(policy));
+        if (open_pool != nullptr && window > 0) write_windows(output, *open_pool, window);
 
-    ///// LOAD PROCESSES INTO PCBS /////
+        output.close();
 
-    // open the generated processes file
-    ifstream load_pcb;
-    // load each process into a new PCB
-    try {
-        load_pcb.open("processes.txt");
-        if (load_pcb.is_open()) {
-            string curline;
-            // read each line and load information into a process object in proc_blocks;
-            int numproc = 0;
-            while (getline(load_pcb, curline)) { // loop through each process
-                numproc++;
-                int argcount = 0;
-                PCB * temp = new PCB();
-                vector<string> table_vals;
-                while (curline.length() > 1) { // loop through each argument
-                    string arg;
-                    while (curline[0] != ',') { // loop through each character
-                        arg += curline[0];
-                        curline.erase(curline.begin());
-                    }
-                    argcount++;
-                    // see which property of the process was just read and set it
-                    if (argcount == 1) { // if a pid
-                        temp->setPID(stoi(arg));
-                        table_vals.push_back(arg);
-                    }
-                    else if (argcount == 2) { // if the arrival time
-                        table_vals.push_back(arg);
-                    }
-                    else if(argcount == 3) { // if the process priority
-                        temp->setPRIORITY(stoi(arg));
-                    }
-                    else if (argcount %2) { // if an io burst
-                        vector<int> curio = temp->getIO_TIME();
-                        // if this is the first argmuent being entered
-                        if (curio[0] == -1) curio.erase(curio.begin());
-                        curio.push_back(stoi(arg));
-                        temp->setIO_TIME(curio);
-                    }
-                    else if (argcount != 0) { // if a cpu burst
-                        vector<int> curcp = temp->getCPU_TIME();
-                        if (curcp[0] == -1) curcp.erase(curcp.begin());
-                        curcp.push_back(stoi(arg));
-                        temp->setCPU_TIME(curcp);
-                    }
-                    else { cout << "Empty line found in process file.\n"; break; } // empty line
-                    curline.erase(curline.begin(), curline.begin()+1); // erase the ", " from the current line being read
-                }
-                // once process is set, load process into proc_blocks and process info into process table
-                temp->setSTATE(1);
-                proc_b.push_back(temp);
-                // fill in table_vals with other empty strings for later use: finish time and assigned cpu
-                table_vals.push_back({""});
-                table_vals.push_back({""});
-                proc_t[temp->getPID() - PIDMIN] = table_vals;
-            }    
-        } else { cerr << "Error opening generated process file for PCB loading."; }
-    } catch(...) { cerr << "Error creating PCBs from generated process file."; }
-    load_pcb.close();
-    //cout << "Successfully loaded into PCBs\n";
-}
+        ofstream latency_file(latency_path);
+        if (!latency_file.is_open()) { cerr << "Error opening latency file " << latency_path << ".\n"; return 1; }
+        bool json = latency_path.size() >= 5 && latency_path.compare(latency_path.size() - 5, 5, ".json") == 0;
+        write_latency(latency_file, latency, json);
+        latency_file.close();
+    }
 
+    if (accounting) {
+        ofstream accounting_file(accounting_path);
+        if (!accounting_file.is_open()) { cerr << "Error opening accounting file " << accounting_path << ".\n"; return 1; }
+        write_accounting(accounting_file, records);
+    }
+
+    if (mismatches > 0) {
+        cerr << mismatches << " of " << last_run - first_run << " runs did not match.\n";
+        return 1;
+    }
+    return 0;
+}
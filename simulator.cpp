@@ -0,0 +1,229 @@
+#pragma once
+#include "tick_engine.cpp"
+#include "event_engine.cpp"
+#include "workload.cpp"
+#include "pool.cpp"
+
+///////////////////////////////////////////////////
+///// SIMULATOR ///////////////////////////////////
+///////////////////////////////////////////////////
+
+// the simulator as a library: set one up, hand it workloads and read back the metrics.
+// a Simulator keeps nothing between runs but its setup and its scratch arena and touches no
+// global state, so any number of them can run at once on different threads.  nothing is
+// read from or written to disk; the file formats in workload.cpp and trace.cpp are up to
+// the caller.  simulation.cpp is the command line built on it
+//
+//     RunSetup setup;
+//     setup.config.cores = 8;
+//     setup.engine = "event";
+//     Simulator simulator(setup);
+//     SimMetrics metrics = simulator.run(workload);        // a ProcessTable, only read
+//     SimMetrics drawn = simulator.run(Rng(seed, 0));      // or one generated from the config
+
+// how to simulate
+struct RunSetup {
+    SimConfig config; // tuning parameters
+    string engine = "tick"; // tick, event or verify
+    PolicyConfig policy; // scheduling policy of the event engine (see policy.cpp)
+    IoConfig io; // io devices of the event engine (see io.cpp)
+    const ProcessTable * replay = nullptr; // workload to replay in every run instead of generating one
+    double arrival_rate = 0; // poisson arrivals per second for generated workloads, 0 for one per ms
+
+    // whether anything is asked for that the tick engine does not model
+    bool needs_event_engine() const {
+        return policy.name != "reserved" || io.devices > 1 || io.channels > 1 || io.discipline != "fifo" || config.affinity != 0;
+    }
+
+    // verify mode on percore: there is no tick engine run to compare with, so the event engine
+    // runs alone and every migration has to be a steal (a process goes back to the core it ran on)
+    bool verifies_steals() const { return engine == "verify" && policy.name == "percore"; }
+
+    // whether the setup makes sense, reporting what does not
+    bool valid() const {
+        if (!config.valid()) return false;
+        if (engine != "tick" && engine != "event" && engine != "verify") { cerr << "Unknown engine: " << engine << endl; return false; }
+        const string& name = policy.name;
+        if (name != "reserved" && name != "srt" && name != "mlfq" && name != "cfs" && name != "percore") {
+            cerr << "Unknown policy: " << name << endl;
+            return false;
+        }
+        if (io.discipline != "fifo" && io.discipline != "sjf" && io.discipline != "elevator") {
+            cerr << "Unknown io discipline: " << io.discipline << endl;
+            return false;
+        }
+        if (io.devices < 1 || io.channels < 1) { cerr << "--io-devices and --io-channels must be at least 1.\n"; return false; }
+        if (verifies_steals() && config.affinity != 0) { cerr << "affinity moves processes without steals, verify cannot check percore with it.\n"; return false; }
+        if (engine != "event" && needs_event_engine() && !verifies_steals()) { cerr << "This policy, io or affinity setup needs the event engine.\n"; return false; }
+        return true;
+    }
+};
+
+// analytics gathered from one simulation run
+struct SimMetrics {
+    long long processes = 0; // processes that went through the system
+    long long simruntime = 0; // sim run time
+    double throughput = 0.0;
+    int turnaround_average = 0;
+    int wait_average = 0;
+    int response_average = 0;
+    long long core_idle = 0; // core idle time is the total idle time accumulated over all cores
+    long long cpu_idle = 0; // cpu idle time is the total time a core was idle
+    long long cpu_bursts = 0; // cpu bursts worked through
+    long long dispatches = 0; // quanta handed to a core
+    long long migrations = 0; // dispatches onto a different core than the process last ran on
+    long long switches = 0; // dispatches onto a core that last ran some other process
+    long long switch_time = 0; // ms of quanta lost to context switches (switchcost)
+    long long migration_time = 0; // ms of quanta lost to migrations (migrationcost)
+    long long steals = 0; // processes taken from another core's run queue
+    vector<IoDeviceStats> io; // what each io device did
+    bool mismatch = false; // verify mode: the engines disagreed on this run
+};
+
+class Simulator {
+    private:
+        RunSetup SETUP;
+        Arena ARENA; // everything a run allocates, handed back at once when it is done
+        EventTracer * TRACER; // where the event engine's decisions go, if anywhere
+        vector<ProcessRecord> * ACCOUNTING; // where every process's record goes, if anywhere
+
+        // the averages over tot_* and the engine's counters
+        static void fill(SimMetrics& metrics, long long processes, long long tot_turnaround, long long tot_wait,
+                         long long tot_response, const SimCounters& counters) {
+            metrics.processes = processes;
+            metrics.simruntime = counters.simruntime;
+            // calculate throughput of this simulation
+            metrics.throughput = counters.simruntime > 0 ? static_cast<double>(processes) / static_cast<double>(counters.simruntime) : 0.0;
+            metrics.turnaround_average = processes > 0 ? tot_turnaround / processes : 0;
+            metrics.response_average = counters.cpu_bursts > 0 ? tot_response / counters.cpu_bursts : 0;
+            metrics.wait_average = processes > 0 ? tot_wait / processes : 0;
+            metrics.core_idle = counters.core_idle;
+            metrics.cpu_idle = counters.cpu_idle;
+            metrics.cpu_bursts = counters.cpu_bursts;
+            metrics.dispatches = counters.dispatches;
+            metrics.migrations = counters.migrations;
+            metrics.switches = counters.switches;
+            metrics.switch_time = counters.switch_time;
+            metrics.migration_time = counters.migration_time;
+            metrics.steals = counters.steals;
+            metrics.io = counters.io;
+        }
+
+        // whether two runs over the same workload came out the same, counters and every process
+        static bool same_run(const ProcessTable& reference, const SimCounters& expected, const ProcessTable& procs, const SimCounters& counters) {
+            bool match = expected.simruntime == counters.simruntime &&
+                         expected.core_idle == counters.core_idle &&
+                         expected.cpu_idle == counters.cpu_idle &&
+                         expected.cpu_bursts == counters.cpu_bursts &&
+                         expected.migrations == counters.migrations &&
+                         expected.dispatches == counters.dispatches &&
+                         expected.switches == counters.switches &&
+                         expected.switch_time == counters.switch_time &&
+                         expected.migration_time == counters.migration_time &&
+                         expected.io[0].busy == counters.io[0].busy &&
+                         expected.io[0].queued == counters.io[0].queued &&
+                         expected.io[0].peak_queue == counters.io[0].peak_queue;
+            for (int i = 0; i < procs.count; i++) {
+                match = match && reference.TURNAROUND[i] == procs.TURNAROUND[i] &&
+                                 reference.WAIT[i] == procs.WAIT[i] &&
+                                 reference.RESPONSE[i] == procs.RESPONSE[i] &&
+                                 reference.FIRST_DISPATCH[i] == procs.FIRST_DISPATCH[i] &&
+                                 reference.FINISH[i] == procs.FINISH[i] &&
+                                 reference.LAST_CORE[i] == procs.LAST_CORE[i] &&
+                                 reference.MIGRATIONS[i] == procs.MIGRATIONS[i] &&
+                                 reference.SWITCHES[i] == procs.SWITCHES[i];
+            }
+            return match;
+        }
+
+        // simulate the workload in procs, whose per-run columns live in the arena
+        SimMetrics simulate(ProcessTable& procs, LatencyHistograms * latency) {
+            SimMetrics metrics;
+            SimCounters counters;
+            if (SETUP.verifies_steals()) {
+                run_event_sim(procs, SETUP.policy, SETUP.io, SETUP.config, ARENA, counters);
+                metrics.mismatch = counters.migrations > counters.steals;
+            } else if (SETUP.engine == "verify") {
+                // run the reference tick engine on a copy of the workload and check the event engine against it
+                ProcessTable reference = procs.attach(ARENA);
+                SimCounters expected;
+                run_tick_sim(reference, SETUP.config, ARENA, expected);
+                run_event_sim(procs, SETUP.policy, SETUP.io, SETUP.config, ARENA, counters);
+                metrics.mismatch = !same_run(reference, expected, procs, counters);
+            } else if (SETUP.engine == "event") {
+                run_event_sim(procs, SETUP.policy, SETUP.io, SETUP.config, ARENA, counters, TRACER);
+            } else {
+                run_tick_sim(procs, SETUP.config, ARENA, counters);
+            }
+            summarize(procs, counters, latency, ACCOUNTING, metrics);
+
+            // hand the whole run's memory back at once
+            ARENA.reset();
+            return metrics;
+        }
+
+        // the metrics of a finished run, adding its processes' times to latency and their records
+        // to accounting if given
+        static void summarize(const ProcessTable& procs, const SimCounters& counters, LatencyHistograms * latency,
+                              vector<ProcessRecord> * accounting, SimMetrics& metrics) {
+            PROFILE_PHASE(PH_SUMMARY);
+            // load turnaround, wait, and response times into analysis variables
+            long long tot_turnaround = 0;
+            long long tot_wait = 0;
+            long long tot_response = 0;
+            for (int i = 0; i < procs.count; i++) {
+                tot_turnaround += procs.TURNAROUND[i];
+                tot_wait += procs.WAIT[i];
+                tot_response += procs.RESPONSE[i];
+                if (latency != nullptr) latency->add(procs.TURNAROUND[i], procs.WAIT[i], procs.RESPONSE[i]);
+            }
+            fill(metrics, procs.count, tot_turnaround, tot_wait, tot_response, counters);
+            if (accounting != nullptr) {
+                for (int i = 0; i < procs.count; i++) accounting->push_back(procs.record(i));
+            }
+        }
+
+    public:
+        Simulator(const RunSetup& setup = RunSetup()) : SETUP(setup), TRACER(nullptr), ACCOUNTING(nullptr) {};
+        Simulator(const Simulator&) = delete;
+        Simulator& operator=(const Simulator&) = delete;
+
+        const RunSetup& setup() const { return SETUP; }
+        // run with another setup from now on, keeping the arena's memory
+        void configure(const RunSetup& setup) { SETUP = setup; }
+        // send the event engine's decisions to tracer (see tracer.cpp), nullptr to stop
+        void trace_to(EventTracer * tracer) { TRACER = tracer; }
+        // add the accounting record of every process of every run to rows, nullptr to stop
+        void account_to(vector<ProcessRecord> * rows) { ACCOUNTING = rows; }
+
+        // simulate workload, which is only read, so one table can be shared by any number of
+        // simulators.  every process's times are added to latency if it is given
+        SimMetrics run(const ProcessTable& workload, LatencyHistograms * latency = nullptr) {
+            ProcessTable procs = workload.attach(ARENA);
+            return simulate(procs, latency);
+        }
+
+        // simulate the setup's replay workload, or one generated from rng with the setup's parameters
+        SimMetrics run(Rng rng, LatencyHistograms * latency = nullptr) {
+            if (SETUP.replay != nullptr) return run(*SETUP.replay, latency);
+            ProcessTable procs;
+            gen_workload(procs, ARENA, rng, SETUP.config, SETUP.arrival_rate);
+            return simulate(procs, latency);
+        }
+
+        // run an open system (a streamed trace or steady-state arrivals, see trace.cpp and
+        // steady.cpp) through the event engine.  processes come and go through the source's
+        // pool, so the averages are taken over its running totals, and the pool keeps the
+        // latency histograms and hands out the accounting records.  false if no process went through
+        template <class Source>
+        bool run_open(Source& source, SimMetrics& metrics) {
+            SimCounters counters;
+            source.pool.accounting = ACCOUNTING;
+            run_event_sim(source, SETUP.policy, SETUP.io, SETUP.config, ARENA, counters, TRACER);
+            ARENA.reset();
+            const ProcessPool& pool = source.pool;
+            if (pool.processes == 0) { cerr << "No processes went through the system.\n"; return false; }
+            fill(metrics, pool.processes, pool.tot_turnaround, pool.tot_wait, pool.tot_response, counters);
+            return true;
+        }
+};
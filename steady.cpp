@@ -0,0 +1,50 @@
+#pragma once
+#include "event_engine.cpp"
+#include "pool.cpp"
+#include "rng.cpp"
+
+///////////////////////////////////////////////////
+///// OPEN-SYSTEM ARRIVALS ////////////////////////
+///////////////////////////////////////////////////
+
+// endless stream of random processes arriving as a poisson process, cut off at duration ms.
+// each process is drawn like the ones gen_workload makes and lives in a recycled pool while
+// it is in the system, so a run of any length needs memory only for the processes in it
+class PoissonSource {
+    private:
+        Rng RNG;
+        SimConfig CONFIG;
+        vector<int> BURSTS; // bursts of the process being generated
+        double MEAN_GAP; // mean time between arrivals in ms
+        int DURATION; // no arrivals from this time on, in ms
+        double NEXT; // arrival time of the next process in ms
+        int PID;
+
+    public:
+        ProcessPool pool;
+
+        PoissonSource(Rng rng, const SimConfig& config, double arrival_rate, int duration)
+            : RNG(rng), CONFIG(config), BURSTS(config.burstmax), MEAN_GAP(1000.0 / arrival_rate), DURATION(duration),
+              PID(config.pidmin), pool(config.burstmax) {
+            NEXT = RNG.exponential(MEAN_GAP);
+        };
+
+        ProcessTable& table() { return pool.table(); }
+
+        int next_arrival() const { return NEXT < DURATION ? arrival_tick(NEXT, CONFIG.rrtime) : -1; }
+
+        int admit() {
+            PROFILE_PHASE(PH_GENERATE);
+            int priority = RNG.below(3) + 1;
+            int count = RNG.below(CONFIG.burstmax - CONFIG.burstmin) + CONFIG.burstmin;
+            for (int j = 0; j < count; j++) {
+                if (j%2) BURSTS[j] = RNG.below(CONFIG.iomax - CONFIG.iomin) + CONFIG.iomin;
+                else BURSTS[j] = RNG.below(CONFIG.cpumax - CONFIG.cpumin) + CONFIG.cpumin;
+            }
+            int row = pool.add(PID++, NEXT, priority, BURSTS.data(), count);
+            NEXT += RNG.exponential(MEAN_GAP);
+            return row;
+        }
+
+        void retire(int row, int tick) { pool.release(row, static_cast<long long>(tick) * CONFIG.rrtime); }
+};
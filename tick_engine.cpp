@@ -0,0 +1,446 @@
+#pragma once
+#include "pcb.cpp"
+#include "config.cpp"
+#include "io.cpp"
+#include "profile.cpp"
+#include <algorithm>
+
+///////////////////////////////////////////////////
+///// TICK ENGINE /////////////////////////////////
+///////////////////////////////////////////////////
+
+// per-run counters filled in by either simulation engine
+// the per-process turnaround, wait and response times are written into the process table.
+// wide enough for a streamed trace that runs far longer than a generated workload
+struct SimCounters {
+    long long simruntime = 0; // total simulated time in ms
+    long long core_idle = 0; // core idle time is the total idle time accumulated over all cores
+    long long cpu_idle = 0; // cpu idle time is the total time the cpu was in an idle state (a core was idle)
+    long long cpu_bursts = 0; // number of cpu bursts worked through
+    long long dispatches = 0; // quanta handed to a core
+    long long migrations = 0; // times a process was dispatched on a different core than it last ran on
+    long long switches = 0; // context switches: dispatches onto a core that last ran some other process
+    long long switch_time = 0; // ms of quanta spent switching processes (switchcost each)
+    long long migration_time = 0; // ms of quanta spent refilling caches after a migration (migrationcost each)
+    long long steals = 0; // processes a core took from another core's run queue
+    vector<IoDeviceStats> io; // what each io device did
+};
+
+// pass a process arriving at arrival ms joins its ready queue on.  it is first dispatched on
+// the pass after, so a process arriving at time 0 is picked up by the very first pass
+inline int arrival_tick(int arrival, int rrtime) {
+    return arrival > 0 ? arrival / rrtime : 0;
+}
+
+// rows of procs in the order they join the ready queues: by arrival pass, ties in row order
+void arrival_order(const ProcessTable& procs, int rrtime, int * order) {
+    for (int i = 0; i < procs.count; i++) order[i] = i;
+    auto earlier = [&](int a, int b) { return arrival_tick(procs.ARRIVAL[a], rrtime) < arrival_tick(procs.ARRIVAL[b], rrtime); };
+    if (!is_sorted(order, order + procs.count, earlier)) stable_sort(order, order + procs.count, earlier);
+}
+
+// fifo of process rows carved from the run's arena.  it starts small and doubles when full,
+// so the slots in use stay in cache as the queue moves along
+struct RowQueue {
+    Arena& arena;
+    int * rows;
+    int mask; // capacity - 1, capacity a power of two
+    int head = 0;
+    int count = 0;
+
+    RowQueue(Arena& from) : arena(from), rows(from.alloc<int>(64)), mask(63) {};
+    bool empty() const { return count == 0; }
+    int size() const { return count; }
+    int front() const { return rows[head]; }
+    void push(int row) {
+        if (count > mask) {
+            int * grown = arena.alloc<int>(2 * (mask + 1));
+            for (int i = 0; i < count; i++) grown[i] = rows[(head + i) & mask];
+            rows = grown;
+            mask = 2 * mask + 1;
+            head = 0;
+        }
+        rows[(head + count) & mask] = row;
+        count++;
+    }
+    void pop() {
+        head = (head + 1) & mask;
+        count--;
+    }
+};
+
+// original fixed-step engine: moves time forward by RRTIME on every pass and scans every
+// core each time.  kept as the reference model.
+// the per-process times are accounted on state changes from a timestamp of the last one,
+// so a pass costs the same however many processes are in the system:
+//  - turnaround: RRTIME for every pass from the one it arrived on to the one it finished on,
+//    plus the cpu time of each burst as it completes (and what its last quantum lost to switching)
+//  - response: RRTIME for every pass between becoming ready and being dispatched
+//  - wait: time from entering the wait queue (at the start of the pass) to the point in
+//    the pass's io budget where its io burst finished
+// a quantum that starts with a context switch loses switchcost ms of it, and migrationcost
+// more if the process last ran on another core.  built for CORES cores, or config.cores if
+// CORES is 0 (see config.cpp).  the per-run scratch columns come from the run's arena
+template <int CORES>
+void run_tick_sim(ProcessTable& procs, const SimConfig& config, Arena& arena, SimCounters& counters) {
+    PROFILE_PHASE(PH_ENGINE);
+    const int CORECOUNT = core_count<CORES>(config);
+    const int RRTIME = config.rrtime;
+    const int HIGHRES = SimConfig::high_reserved(CORECOUNT); // reserved core amount for high priority processes
+    const int MEDRES = SimConfig::medium_reserved(CORECOUNT); // reserved core amount for medium priority processes
+    const int SWITCHCOST = config.switchcost;
+    const int MIGRATIONCOST = config.migrationcost;
+
+    // different process queues based on priority
+    RowQueue high_queue(arena); // high priority processes get assigned to half of the available processors
+    RowQueue med_queue(arena); // medium priority processes get assigned to a third of the available processors
+    RowQueue low_queue(arena); // low priority processes get assigned to the remaining processors
+    RowQueue wait_queue(arena); // queue for processes waiting on an io burst
+
+    // core array, holds the row of the process it is currently handling
+    // if -1, then no process currently assigned
+    CoreSlots<int, CORES> cores(CORECOUNT, -1);
+
+    // columns touched every pass
+    const int n = procs.count;
+    int * STATE = procs.STATE;
+    int * TURNAROUND = procs.TURNAROUND;
+    int * WAIT = procs.WAIT;
+    int * RESPONSE = procs.RESPONSE;
+    const int * PRIORITY = procs.PRIORITY;
+    int * CPU_LEFT = procs.CPU_LEFT;
+    int * IO_LEFT = procs.IO_LEFT;
+
+    // start every process on its first burst
+    procs.rewind();
+
+    // nothing is in the system until it arrives (state 0)
+    for (int i = 0; i < n; i++) {
+        STATE[i] = 0;
+        TURNAROUND[i] = 0;
+        WAIT[i] = 0;
+        RESPONSE[i] = 0;
+        procs.clear_accounting(i);
+    }
+
+    // timestamps of the last state changes
+    int * entry_pass = arena.fill<int>(n, 0); // pass the process arrived on
+    int * ready_pass = arena.fill<int>(n, -1); // pass the process became ready on, -1 once dispatched
+    int * io_entry = arena.fill<int>(n, 0); // time the process entered the wait queue, in ms
+
+    // processes join the queues in arrival order
+    int * order = arena.alloc<int>(n);
+    arrival_order(procs, RRTIME, order);
+    int next_arrival = 0; // next entry of order to arrive
+    int pass = 0;
+
+    // initialize arriving processes into their respectful queues
+    auto admit_arrivals = [&]() {
+        PROFILE_PHASE(PH_ARRIVALS);
+        while (next_arrival < n && arrival_tick(procs.ARRIVAL[order[next_arrival]], RRTIME) <= pass) {
+            int i = order[next_arrival++];
+            if (PRIORITY[i] == 1) {
+                high_queue.push(i); // if a high priority process, add to high priority queue
+            } else if (PRIORITY[i] == 2) {
+                med_queue.push(i); // if a medium priority process, add to high priority queue
+            } else if (PRIORITY[i] == 3) {
+                low_queue.push(i); // if a low priority process, add to high priority queue
+            } else {
+                // should not be reached, would mean a process was given an invalid priority
+                cerr << "Invalid process priority.\n";
+            }
+            STATE[i] = 1;
+            entry_pass[i] = pass;
+            ready_pass[i] = pass;
+        }
+    };
+    admit_arrivals();
+
+    //cout << "processes initialized\n";
+
+    // values for analytics per sim
+    int sim_simruntime = 0;
+    int sim_core_idle = 0; // core idle time is the total idle time accumulated over all cores
+    int sim_cpu_idle = 0; // cpu idle time is the total time the cpu was in an idle state (a core was idle)
+    int cpu_bursts = 0; // keep track of number of cpu bursts worked through
+    long long migrations = 0; // keep track of processes moved between cores
+    long long dispatches = 0; // keep track of quanta handed out
+    long long switches = 0; // keep track of context switches
+    CoreSlots<int, CORES> core_last(CORECOUNT, -1); // process each core last ran
+    CoreSlots<int, CORES> overhead(CORECOUNT, 0); // ms of its current quantum each core loses to switching
+    long long switch_time = 0;
+    long long migration_time = 0;
+    IoDeviceStats device; // the one io device
+
+    // used for calculating time of last process and adding to analysis values
+    // these hold the most recent value seen across passes, and start at 0 in case one is never set
+    int final_cpu_time = 0;
+    int final_io_time = 0; // used in similar fashion to final_cpu_time, only meant for if last io_burst
+
+    ///// MAIN PROCESS HANDLER /////
+
+    bool run = true;
+    while (run) {
+        pass++;
+        PROFILE_PASS();
+        // increment simruntime time by round robin value when no process was a finished process
+        sim_simruntime += RRTIME;
+
+        ///// CURRENT PROCESSES /////
+
+        PROFILE_ENTER(PH_RUNNING);
+        bool idle = false; // if a core was idle, only increment cpu idle time once
+        // check each process currently in a processor
+        for (int i = 0; i < CORECOUNT; i++) {
+            if (cores[i] >= 0) { // if there is a process assigned to this core
+                // subtract round robin time, and see if process has finished.
+                // if so,  add CPU_TIME to the turnaround, remove burst from its cpu bursts
+                // otherwise, move back into its queue type
+                int p = cores[i];
+                if (!procs.has_cpu(p)) break;
+
+                // the quantum minus whatever the switch onto this core took
+                int time = CPU_LEFT[p] - (RRTIME - overhead[i]);
+                if (time <= 0) { // if process is complete
+                    // update the turnaround based on the fact that this process is complete and may not have used
+                    // the full round robin time quantum
+                    TURNAROUND[p] += overhead[i] + CPU_LEFT[p];
+                    // erase that process's cpu burst
+                    procs.next_cpu(p);
+                    // check if process has an IO burst next
+                    if (procs.has_io(p)) {
+                        wait_queue.push(cores[i]); // add this process to the wait queue
+                        STATE[p] = 2; // update process state to "waiting"
+                        io_entry[p] = pass * RRTIME;
+                    } else { // if process is complete (no need to check cpu_bursts, since it will not have two in a row)
+                        STATE[p] = 4; // update process state to "finished"
+                        procs.FINISH[p] = static_cast<long long>(pass) * RRTIME;
+                        TURNAROUND[p] += RRTIME * (pass - entry_pass[p]);
+                    }
+
+                    // set final cpu_time val in case it is needed
+                    final_cpu_time = time + RRTIME;
+                    cpu_bursts++;
+                } else { // if process is not complete
+                    // subtract necessary cpu times
+                    CPU_LEFT[p] = time;
+                    // move process back into its queue based on priority type
+                    if (PRIORITY[p] == 1) {
+                        high_queue.push(cores[i]);
+                    } else if (PRIORITY[p] == 2) {
+                        med_queue.push(cores[i]);
+                    } else if (PRIORITY[p] == 3) {
+                        low_queue.push(cores[i]);
+                    }
+                    // if priority is not one of these options, then it either was never assigned a priority or it is finished
+                    // should not reach this part of the code, but if it does throw an error
+                    else cerr << "Process priority mishandle.\n";
+                }
+            } else { // if core not being used,  add idle time
+                if (!idle) {
+                    sim_cpu_idle += RRTIME;
+                    idle = true;
+                }
+                sim_core_idle += RRTIME;
+            }
+            // reset core to "available" flag
+            // all cores should be reset to available each cycle
+            cores[i] = -1;
+        }
+
+        PROFILE_LEAVE();
+
+        // cout << "current processes dealt with\n";
+
+        ///// LOADING IN NEW PROCESSES /////
+
+        PROFILE_ENTER(PH_DISPATCH);
+        // assign processors to new processes
+        // each of these are based on a FCFS within each queue
+        // assign half of the processors to high priority processes
+        for (int i = 0; i < HIGHRES; i++) {
+            if (!high_queue.empty()) {
+                cores[i] = high_queue.front(); // set the core to the first available process in the queue
+                high_queue.pop(); // remove that process from the process queue
+                STATE[cores[i]] = 3; // update process state to "running"
+            }
+        }
+
+        // assign one third of the processors to medium priority processes
+        for (int i = HIGHRES; i < HIGHRES + MEDRES; i++) {
+            if (!med_queue.empty()) {
+                cores[i] = med_queue.front(); // set the core to the first available process in the queue
+                med_queue.pop(); // remove that process from the process queue
+                STATE[cores[i]] = 3; // update process state to "running"
+            }
+        }
+
+        // assign remaining processors to low priority processes
+        for (int i = HIGHRES + MEDRES; i < CORECOUNT; i++) {
+            if (!low_queue.empty()) {
+                cores[i] = low_queue.front(); // set the core to the first available process in the queue
+                low_queue.pop(); // remove that process from the process queue
+                STATE[cores[i]] = 3; // update process state to "running"
+            }
+        }
+
+        // after each queue has had a chance to get a core assigned, assign any remaining available processors
+        // to the next available process in high queue, then med queue, then low queue
+        for (int i = 0; i < CORECOUNT; i++) {
+            if (cores[i] == -1) {
+                if (!high_queue.empty()) {
+                    cores[i] = high_queue.front(); // set the core to the first available process in the queue
+                    high_queue.pop(); // remove that process from the process queue
+                    STATE[cores[i]] = 3; // update process state to "running"
+                } else if (!med_queue.empty()) {
+                    cores[i] = med_queue.front(); // set the core to the first available process in the queue
+                    med_queue.pop(); // remove that process from the process queue
+                    STATE[cores[i]] = 3; // update process state to "running"
+                } else if (!low_queue.empty()) {
+                    cores[i] = low_queue.front(); // set the core to the first available process in the queue
+                    low_queue.pop(); // remove that process from the process queue
+                    STATE[cores[i]] = 3; // update process state to "running"
+                }
+                // if all queues empty, core stays empty and idle time will be added in next cycle (above)
+            }
+        }
+
+        // add the time spent waiting in a queue to the response time of every process that just got
+        // a core, and count every process that landed on a different core than last time
+        bool running = false;
+        for (int i = 0; i < CORECOUNT; i++) {
+            if (cores[i] >= 0) {
+                int p = cores[i];
+                if (ready_pass[p] >= 0) {
+                    RESPONSE[p] += RRTIME * (pass - ready_pass[p]);
+                    ready_pass[p] = -1;
+                }
+                if (procs.FIRST_DISPATCH[p] < 0) procs.FIRST_DISPATCH[p] = static_cast<long long>(pass) * RRTIME;
+                overhead[i] = 0;
+                if (procs.LAST_CORE[p] >= 0 && procs.LAST_CORE[p] != i) {
+                    migrations++;
+                    procs.MIGRATIONS[p]++;
+                    overhead[i] += MIGRATIONCOST;
+                    migration_time += MIGRATIONCOST;
+                }
+                procs.LAST_CORE[p] = i;
+                if (core_last[i] != p) {
+                    switches++;
+                    procs.SWITCHES[p]++;
+                    core_last[i] = p;
+                    overhead[i] += SWITCHCOST;
+                    switch_time += SWITCHCOST;
+                }
+                dispatches++;
+                running = true;
+            }
+        }
+
+        PROFILE_LEAVE();
+
+        // processes arriving on this pass queue up behind the ones that were just loaded
+        admit_arrivals();
+
+        // other dispatch policies (srt, mlfq, cfs) live in policy.cpp and run on the event engine
+
+        //cout << "new processes loaded in\n";
+
+        ///// HANDLING IO BURSTS /////
+
+        // check next IO burst up in the queue. if round robin time is sufficient, then pass back to cpu queues if applicable
+        // and properly update wait time and turnaround
+        // this is organized so that every round robin cycle, we will get exactly RRTIME's worth of io_burst time worked through
+        PROFILE_ENTER(PH_IO);
+        int totio = 0;
+        bool io_processing = true;
+        // everything behind the burst at the front is queued
+        if (wait_queue.size() > 1 && static_cast<int>(wait_queue.size()) - 1 > device.peak_queue) device.peak_queue = wait_queue.size() - 1;
+        while( io_processing ) {
+            if (!wait_queue.empty()) {
+                // add next io burst to io time processed this round
+                int p = wait_queue.front();
+                int io_burst = IO_LEFT[p];
+                //if (io_burst != -1) { // for handling weird error where an io burst is -1
+                    totio += io_burst;
+                    int iorrdiff = RRTIME - totio;
+                    if (iorrdiff < 0) { // if we have used up all round robin time in io bursts (i.e. this process did not fulfill its io burst)
+                        // what did not fit is left for the next pass
+                        IO_LEFT[p] = -iorrdiff;
+
+                        io_processing = false;
+
+                        // update final_io_time for future reference based on final burst times
+                        final_io_time = io_burst;
+                    } else { // if we have not used up all of the wait time (i.e. this process fulfilled its io burst)
+                        if (iorrdiff == 0) io_processing = false; // if used up, pop process off and exit
+                        // waited from entering the queue until this burst finished, part way into the pass
+                        WAIT[p] += pass * RRTIME + totio - io_entry[p];
+                        device.busy += procs.BURSTS[procs.IO_NEXT[p]];
+                        device.queued += pass * RRTIME + totio - io_entry[p] - procs.BURSTS[procs.IO_NEXT[p]];
+
+                        // remove the used io_burst from the process
+                        procs.next_io(p);
+
+                        // if process has another cpu burst, send back to its queue
+                        if (procs.has_cpu(p)) {
+                            // send process back to its respective queue
+                            if (PRIORITY[p] == 1) {
+                                high_queue.push(wait_queue.front());
+                            } else if (PRIORITY[p] == 2) {
+                                med_queue.push(wait_queue.front());
+                            } else { // guaranteed to be a low-priority process, as any other value would not have made it his far
+                                low_queue.push(wait_queue.front());
+                            }
+                            STATE[p] = 1; // update state to ready
+                            ready_pass[p] = pass;
+                        } else { // if no remaining cpu bursts, process is then finished (no need to check io bursts, since it will not have two in a row)
+                            STATE[p] = 4; // update process state to "finished"
+                            procs.FINISH[p] = static_cast<long long>(pass) * RRTIME;
+                            TURNAROUND[p] += RRTIME * (pass - entry_pass[p]);
+                        }
+                        wait_queue.pop();
+                    }
+                //} else wait_queue.pop();
+            } else io_processing = false;
+        }
+
+        PROFILE_LEAVE();
+
+        //cout << "io bursts handled\n";
+
+        // if all queues are empty, no core has work and nothing is left to arrive, quit
+        if (high_queue.empty() &&
+            med_queue.empty() &&
+            low_queue.empty() &&
+            wait_queue.empty() &&
+            !running &&
+            next_arrival == n)  {
+                run = false;
+                //cout << "Simulation Run Complete." << endl;
+                // update with final burst time splits
+                sim_simruntime += final_cpu_time += final_io_time;
+            }
+    }
+
+    // anything still in the system (only a process with an invalid priority never gets anywhere)
+    // was alive up to the last pass
+    for (int i = 0; i < n; i++) {
+        if (STATE[i] != 0 && STATE[i] != 4) TURNAROUND[i] += RRTIME * (pass - entry_pass[i]);
+    }
+
+    counters.simruntime = sim_simruntime;
+    counters.core_idle = sim_core_idle;
+    counters.cpu_idle = sim_cpu_idle;
+    counters.cpu_bursts = cpu_bursts;
+    counters.migrations = migrations;
+    counters.dispatches = dispatches;
+    counters.switches = switches;
+    counters.switch_time = switch_time;
+    counters.migration_time = migration_time;
+    counters.io.assign(1, device);
+}
+
+// run with the core count of config, through the specialized build if there is one for it
+void run_tick_sim(ProcessTable& procs, const SimConfig& config, Arena& arena, SimCounters& counters) {
+    with_core_count(config.cores, [&](auto cores) { run_tick_sim<decltype(cores)::value>(procs, config, arena, counters); });
+}
@@ -0,0 +1,155 @@
+#pragma once
+#include "event_engine.cpp"
+#include "workload.cpp"
+#include "pool.cpp"
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+///////////////////////////////////////////////////
+///// STREAMING TRACE READER //////////////////////
+///////////////////////////////////////////////////
+
+// reads a trace file one line at a time through a fixed buffer, so a trace of any length
+// is read with the memory of its longest line.  the buffer is refilled with plain read()
+// calls and lines are handed out in place, never copied
+class TraceReader {
+    private:
+        static const size_t CHUNK = 1 << 20; // starting buffer size in bytes
+        int FD;
+        vector<char> BUFFER;
+        size_t BEGIN; // unread bytes are BUFFER[BEGIN, END)
+        size_t END;
+        bool AT_EOF;
+        long long LINE; // number of the line last handed out
+
+    public:
+        TraceReader() : FD(-1), BEGIN(0), END(0), AT_EOF(false), LINE(0) {};
+        ~TraceReader() { if (FD >= 0) ::close(FD); }
+        TraceReader(const TraceReader&) = delete;
+        TraceReader& operator=(const TraceReader&) = delete;
+
+        bool open(const string& path) {
+            FD = ::open(path.c_str(), O_RDONLY);
+            if (FD < 0) { cerr << "Error opening trace file " << path << ".\n"; return false; }
+            BUFFER.resize(CHUNK);
+            return true;
+        }
+
+        // next line as [first, last), without its newline.  false at the end of the trace
+        bool next_line(const char *& first, const char *& last) {
+            while (true) {
+                const char * start = BUFFER.data() + BEGIN;
+                const char * newline = static_cast<const char *>(memchr(start, '\n', END - BEGIN));
+                if (newline != nullptr) {
+                    first = start;
+                    last = newline;
+                    BEGIN = newline + 1 - BUFFER.data();
+                    LINE++;
+                    return true;
+                }
+                if (AT_EOF) {
+                    if (BEGIN == END) return false;
+                    // last line with no newline after it
+                    first = start;
+                    last = BUFFER.data() + END;
+                    BEGIN = END;
+                    LINE++;
+                    return true;
+                }
+                // move the partial line to the front and read in behind it,
+                // growing the buffer only when one line does not fit in it
+                memmove(BUFFER.data(), start, END - BEGIN);
+                END -= BEGIN;
+                BEGIN = 0;
+                if (END == BUFFER.size()) BUFFER.resize(2 * BUFFER.size());
+                ssize_t got = ::read(FD, BUFFER.data() + END, BUFFER.size() - END);
+                if (got < 0) { cerr << "Error reading trace file.\n"; got = 0; }
+                if (got == 0) AT_EOF = true;
+                END += got;
+            }
+        }
+
+        long long line() const { return LINE; }
+};
+
+///////////////////////////////////////////////////
+///// STREAMING TRACE SOURCE //////////////////////
+///////////////////////////////////////////////////
+
+// feeds the processes of a trace ("PID, arrival, priority, CPU, IO, CPU, ..." per line,
+// arrivals in ms and in non-decreasing order) to the event engine as their arrival time
+// comes up, holding only the processes in the system in its pool
+class TraceSource {
+    private:
+        TraceReader READER;
+        vector<int> FIELDS; // pid, arrival, priority and bursts of the next process in the trace
+        bool PENDING; // FIELDS holds a process that has not been admitted yet
+        bool FAILED;
+        int LAST_ARRIVAL;
+        int RRTIME;
+
+        // parse the next process out of the trace into FIELDS.  a bad line ends the trace
+        // there and sets FAILED
+        bool read_process() {
+            PROFILE_PHASE(PH_PARSE);
+            const char * first;
+            const char * last;
+            while (READER.next_line(first, last)) {
+                FIELDS.clear();
+                int value;
+                for (const char * p = first; scan_int(p, last, value); ) FIELDS.push_back(value);
+                if (FIELDS.empty()) continue; // blank line
+                if (FIELDS.size() < 4) {
+                    cerr << "Process line with no cpu burst on trace line " << READER.line() << ".\n";
+                    FAILED = true;
+                    return false;
+                }
+                if (FIELDS[2] < 1 || FIELDS[2] > 3) {
+                    cerr << "Invalid process priority on trace line " << READER.line() << ".\n";
+                    FAILED = true;
+                    return false;
+                }
+                if (FIELDS[1] < LAST_ARRIVAL) {
+                    cerr << "Arrival time goes backwards on trace line " << READER.line() << ".\n";
+                    FAILED = true;
+                    return false;
+                }
+                for (int j = 3; j < FIELDS.size(); j++) {
+                    if (FIELDS[j] > 0) continue;
+                    cerr << "Burst " << j - 2 << " of process " << FIELDS[0] << " on trace line " << READER.line() << " is not positive.\n";
+                    FAILED = true;
+                    return false;
+                }
+                LAST_ARRIVAL = FIELDS[1];
+                return true;
+            }
+            return false;
+        }
+
+    public:
+        ProcessPool pool;
+
+        TraceSource(const SimConfig& config) : PENDING(false), FAILED(false), LAST_ARRIVAL(0), RRTIME(config.rrtime), pool(config.burstmax) {};
+
+        bool open(const string& path) { return READER.open(path); }
+
+        // whether reading stopped on a bad line rather than at the end of the trace
+        bool failed() const { return FAILED; }
+
+        ProcessTable& table() { return pool.table(); }
+
+        int next_arrival() {
+            if (!PENDING && !FAILED) PENDING = read_process();
+            return PENDING ? arrival_tick(FIELDS[1], RRTIME) : -1;
+        }
+
+        int admit() {
+            PENDING = false;
+            return pool.add(FIELDS[0], FIELDS[1], FIELDS[2], FIELDS.data() + 3, FIELDS.size() - 3);
+        }
+
+        void retire(int row, int tick) { pool.release(row, static_cast<long long>(tick) * RRTIME); }
+};
@@ -0,0 +1,115 @@
+// converts an event trace written with --event-trace into chrome trace json, for
+// chrome://tracing or ui.perfetto.dev.  every run is a process with one track per core, one
+// per io channel and one for finishes; a quantum on a core or a burst on a channel is a slice
+// named after the process's pid.
+// build and run: g++ -O2 trace_export.cpp -o trace_export && ./trace_export events.bin trace.json [--run=N]
+//  --run  only export this run (runs are numbered from 0)
+#include "tracer.cpp"
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <unordered_map>
+
+#define IOTRACK 100000 // track of io channel c is IOTRACK + c
+#define FINISHTRACK 200000 // track finishes are shown on
+
+///// JSON OUTPUT /////
+
+static bool first_event = true;
+
+// separator before every event but the first
+void next_event(FILE * out) {
+    if (!first_event) fprintf(out, ",\n");
+    first_event = false;
+}
+
+// name the run's process and the track the first time either shows up
+void name_track(FILE * out, set<long long>& named, int run, int track) {
+    if (named.insert(static_cast<long long>(run) << 32 | 0xffffffffLL).second) {
+        next_event(out);
+        fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"run %d\"}}", run, run);
+        next_event(out);
+        fprintf(out, "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"sort_index\":%d}}", run, run);
+    }
+    if (!named.insert(static_cast<long long>(run) << 32 | track).second) return;
+    char name[32];
+    if (track >= FINISHTRACK) snprintf(name, sizeof(name), "finished");
+    else if (track >= IOTRACK) snprintf(name, sizeof(name), "io channel %d", track - IOTRACK);
+    else snprintf(name, sizeof(name), "core %d", track);
+    next_event(out);
+    fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", run, track, name);
+    next_event(out);
+    fprintf(out, "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"sort_index\":%d}}", run, track, track);
+}
+
+// a slice from start to end on track, times in ms (chrome wants microseconds)
+void slice(FILE * out, set<long long>& named, const TraceRecord& start, const TraceRecord& end, int track, const char * category, const char * ending) {
+    name_track(out, named, start.run, track);
+    next_event(out);
+    fprintf(out, "{\"name\":\"PID %d\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%lld,\"dur\":%lld,\"args\":{\"end\":\"%s\"}}",
+            start.pid, category, start.run, track, static_cast<long long>(start.time) * 1000,
+            (static_cast<long long>(end.time) - start.time) * 1000, ending);
+}
+
+int main(int argc, char * argv[]) {
+    string in_path, out_path;
+    int only_run = -1;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--run=", 6) == 0) only_run = atoi(argv[i] + 6);
+        else if (in_path.empty()) in_path = argv[i];
+        else if (out_path.empty()) out_path = argv[i];
+        else { cerr << "Unknown argument: " << argv[i] << endl; return 1; }
+    }
+    if (in_path.empty() || out_path.empty()) { cerr << "usage: trace_export EVENTS TRACE.json [--run=N]\n"; return 1; }
+
+    ifstream in(in_path, ios::binary);
+    if (!in.is_open()) { cerr << "Error opening event trace file " << in_path << ".\n"; return 1; }
+    TraceHeader header;
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!in || memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0) {
+        cerr << in_path << " is not an event trace.\n";
+        return 1;
+    }
+    FILE * out = fopen(out_path.c_str(), "w");
+    if (out == nullptr) { cerr << "Error opening output file " << out_path << ".\n"; return 1; }
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"cores\":%d,\"rrtime\":%d},\"traceEvents\":[\n", header.cores, header.rrtime);
+
+    // slice opened on each (run, core) and (run, io channel), waiting for its end
+    unordered_map<long long, TraceRecord> on_core, on_channel;
+    set<long long> named;
+    vector<TraceRecord> block(1 << 16);
+    long long records = 0, unmatched = 0;
+    while (in) {
+        in.read(reinterpret_cast<char *>(block.data()), sizeof(TraceRecord) * block.size());
+        size_t count = in.gcount() / sizeof(TraceRecord);
+        for (size_t i = 0; i < count; i++) {
+            const TraceRecord& r = block[i];
+            if (only_run >= 0 && r.run != only_run) continue;
+            records++;
+            long long key = static_cast<long long>(r.run) << 32 | static_cast<uint16_t>(r.slot);
+            if (r.kind == TR_DISPATCH) on_core[key] = r;
+            else if (r.kind == TR_IO_START) on_channel[key] = r;
+            else if (r.kind == TR_PREEMPT || r.kind == TR_BURST_END) {
+                unordered_map<long long, TraceRecord>::iterator it = on_core.find(key);
+                if (it == on_core.end() || it->second.pid != r.pid) { unmatched++; continue; }
+                slice(out, named, it->second, r, r.slot, "cpu", r.kind == TR_PREEMPT ? "preempt" : "burst end");
+                on_core.erase(it);
+            } else if (r.kind == TR_IO_END) {
+                unordered_map<long long, TraceRecord>::iterator it = on_channel.find(key);
+                if (it == on_channel.end() || it->second.pid != r.pid) { unmatched++; continue; }
+                slice(out, named, it->second, r, IOTRACK + r.slot, "io", "io end");
+                on_channel.erase(it);
+            } else if (r.kind == TR_FINISH) {
+                name_track(out, named, r.run, FINISHTRACK);
+                next_event(out);
+                fprintf(out, "{\"name\":\"PID %d\",\"cat\":\"finish\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,\"tid\":%d,\"ts\":%lld}",
+                        r.pid, r.run, FINISHTRACK, static_cast<long long>(r.time) * 1000);
+            } else unmatched++;
+        }
+    }
+    fprintf(out, "\n]}\n");
+    if (fclose(out) != 0) { cerr << "Error writing output file " << out_path << ".\n"; return 1; }
+    // slices still open belong to processes that were on a core or channel when the run stopped
+    cerr << records << " records, " << on_core.size() + on_channel.size() << " slices left open, " << unmatched << " unmatched records.\n";
+    return 0;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+using namespace std;
+
+///////////////////////////////////////////////////
+///// EVENT TRACE /////////////////////////////////
+///////////////////////////////////////////////////
+
+// optional record of every scheduling decision the event engine makes, for looking at a run
+// after the fact (trace_export.cpp turns it into a chrome trace).  records are packed into a
+// fixed-size buffer per worker thread and the buffer is written out in one block whenever it
+// fills, so recording an event is a 16 byte store and nothing is ever dropped
+
+// what a record is about
+enum TraceKind {
+    TR_DISPATCH = 0, // process loaded onto a core for a quantum
+    TR_PREEMPT = 1, // quantum used up with cpu time left, process back to ready
+    TR_BURST_END = 2, // cpu burst done before the quantum ran out, core given up
+    TR_IO_START = 3, // io channel starts on the burst
+    TR_IO_END = 4, // io burst done
+    TR_FINISH = 5 // process left the system
+};
+
+struct TraceRecord {
+    uint32_t time; // ms into the run
+    int32_t pid;
+    int32_t run; // run number
+    int16_t slot; // core for cpu records, io channel for io records, -1 for finish
+    uint8_t kind; // TraceKind
+    uint8_t unused;
+};
+static_assert(sizeof(TraceRecord) == 16, "trace records are packed into 16 bytes");
+
+// trace files start with this header, then records until the end of the file.  blocks of
+// records from different workers interleave, but the records of one run are in time order
+struct TraceHeader {
+    char magic[8]; // TRACE_MAGIC
+    int32_t cores;
+    int32_t rrtime;
+};
+
+const char TRACE_MAGIC[8] = {'O', 'S', 'P', 'S', 'E', 'V', '1', '\0'};
+
+// the file every worker's records go to
+class TraceFile {
+    private:
+        ofstream OUT;
+        mutex LOCK;
+        bool FAILED;
+
+    public:
+        TraceFile() : FAILED(false) {};
+
+        bool open(const string& path, int cores, int rrtime) {
+            OUT.open(path, ios::binary);
+            if (!OUT.is_open()) { cerr << "Error opening event trace file " << path << ".\n"; return false; }
+            TraceHeader header;
+            memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+            header.cores = cores;
+            header.rrtime = rrtime;
+            OUT.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            return true;
+        }
+
+        void write(const TraceRecord * records, size_t count) {
+            lock_guard<mutex> hold(LOCK);
+            OUT.write(reinterpret_cast<const char *>(records), sizeof(TraceRecord) * count);
+            if (!OUT.good()) FAILED = true;
+        }
+
+        // whether every block made it to disk
+        bool close() {
+            OUT.close();
+            if (FAILED) cerr << "Error writing event trace file.\n";
+            return !FAILED;
+        }
+};
+
+// one worker's buffer.  the engine calls record() at each event; run is stamped on every
+// record so runs from different workers can be told apart
+class EventTracer {
+    private:
+        static const int CAPACITY = 1 << 16; // records per block, 1 MB
+        TraceFile& SINK;
+        vector<TraceRecord> BUFFER;
+        int USED;
+
+    public:
+        int run = 0;
+
+        EventTracer(TraceFile& file) : SINK(file), BUFFER(CAPACITY), USED(0) {};
+        ~EventTracer() { flush(); }
+
+        void record(TraceKind kind, long long time, int pid, int slot) {
+            TraceRecord& r = BUFFER[USED];
+            r.time = static_cast<uint32_t>(time);
+            r.pid = pid;
+            r.run = run;
+            r.slot = static_cast<int16_t>(slot);
+            r.kind = static_cast<uint8_t>(kind);
+            r.unused = 0;
+            if (++USED == CAPACITY) flush();
+        }
+
+        void flush() {
+            if (USED > 0) SINK.write(BUFFER.data(), USED);
+            USED = 0;
+        }
+};
@@ -0,0 +1,269 @@
+#pragma once
+#include "pcb.cpp"
+#include "config.cpp"
+#include "rng.cpp"
+#include "profile.cpp"
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+///////////////////////////////////////////////////
+///// RANDOM WORKLOAD GENERATION //////////////////
+///////////////////////////////////////////////////
+
+// fill procs with a random workload drawn straight from rng, with no text round trip.
+// each process gets a unique PID, an arrival time, a priority and a random number of
+// alternating cpu / io bursts, starting and ending with a cpu burst where the count allows.
+// arrivals are one per ms, or a poisson process of arrival_rate processes per second if given.
+// counts and burst lengths are drawn from the ranges in config
+void gen_workload(ProcessTable& procs, Arena& arena, Rng& rng, const SimConfig& config, double arrival_rate = 0) {
+    PROFILE_PHASE(PH_GENERATE);
+    // create a random number of processes
+    int num_processes = rng.below(config.procmax - config.procmin) + config.procmin;
+    // room for the most bursts possible, the unused tail is simply left in the arena
+    ProcessTable::WorkloadColumns columns = procs.allocate(arena, num_processes, static_cast<long long>(num_processes) * config.burstmax);
+
+    int offset = 0;
+    double arrival = 0;
+    for (int i = 0; i < num_processes; i++) {
+        columns.pid[i] = i + config.pidmin;
+        if (arrival_rate > 0) arrival += rng.exponential(1000.0 / arrival_rate);
+        else arrival = i;
+        columns.arrival[i] = arrival;
+        // generate a random priority for this process
+        columns.priority[i] = rng.below(3) + 1;
+        // generate a random number of cpu / io bursts
+        int bursts = rng.below(config.burstmax - config.burstmin) + config.burstmin;
+        // this process's cpu bursts go first, then its io bursts
+        columns.cpu_begin[i] = columns.cpu_end[i] = offset;
+        columns.io_begin[i] = columns.io_end[i] = offset + (bursts + 1) / 2;
+        for (int j = 0; j < bursts; j++) {
+            // if this will be an io burst
+            // generate random amount of time for the io burst
+            if (j%2) columns.bursts[columns.io_end[i]++] = rng.below(config.iomax - config.iomin) + config.iomin;
+            // if this will be a cpu burst
+            else columns.bursts[columns.cpu_end[i]++] = rng.below(config.cpumax - config.cpumin) + config.cpumin;
+        }
+        offset = columns.io_end[i];
+    }
+    procs.burst_count = offset;
+}
+
+///////////////////////////////////////////////////
+///// TEXT WORKLOAD FORMAT ////////////////////////
+///////////////////////////////////////////////////
+
+// key for this format is: PID, Arrival Time, Priority, CPU Burst, IO Burst, CPU Burst, IO Burst, etc
+// one process per line.  kept for inspecting workloads by eye and for hand-written ones
+
+void write_workload_text(const ProcessTable& procs, ostream& out) {
+    for (int i = 0; i < procs.count; i++) {
+        out << procs.PID[i] << ", " << procs.ARRIVAL[i] << ", " << procs.PRIORITY[i] << ", ";
+        int cpu = procs.CPU_BEGIN[i], io = procs.IO_BEGIN[i];
+        while (cpu < procs.CPU_END[i] || io < procs.IO_END[i]) {
+            if (cpu < procs.CPU_END[i]) out << procs.BURSTS[cpu++] << ", ";
+            if (io < procs.IO_END[i]) out << procs.BURSTS[io++] << ", ";
+        }
+        if (i < procs.count - 1) out << endl; // remove empty line at the end
+    }
+}
+
+// pull the next integer out of [p, end), skipping the separators in front of it.
+// returns false once the range has no more numbers
+inline bool scan_int(const char *& p, const char * end, int& value) {
+    while (p < end && *p != '-' && (*p < '0' || *p > '9')) p++;
+    if (p == end) return false;
+    bool negative = (*p == '-');
+    if (negative) p++;
+    int v = 0;
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+    value = negative ? -v : v;
+    return true;
+}
+
+// parse a text workload held in [text, text_end) into procs.  each line is scanned once to
+// count its numbers and once to load them, so the cost is linear in the size of the text
+bool parse_workload_text(const char * text, const char * text_end, ProcessTable& procs, Arena& arena) {
+    PROFILE_PHASE(PH_PARSE);
+    // first pass: size the table
+    int processes = 0;
+    long long bursts = 0;
+    for (const char * line = text; line < text_end; ) {
+        const char * line_end = static_cast<const char *>(memchr(line, '\n', text_end - line));
+        if (line_end == nullptr) line_end = text_end;
+        int fields = 0, value;
+        for (const char * p = line; scan_int(p, line_end, value); ) fields++;
+        if (fields >= 4) { processes++; bursts += fields - 3; }
+        else if (fields > 0) { cerr << "Process line with no cpu burst in workload.\n"; return false; }
+        line = line_end + 1;
+    }
+    // the offsets into the burst column are ints
+    if (bursts > INT_MAX) { cerr << "Workload has more than " << INT_MAX << " bursts.\n"; return false; }
+
+    // second pass: load each line into its row
+    ProcessTable::WorkloadColumns columns = procs.allocate(arena, processes, bursts);
+    int row = 0, offset = 0, lineno = 0;
+    for (const char * line = text; line < text_end; ) {
+        const char * line_end = static_cast<const char *>(memchr(line, '\n', text_end - line));
+        if (line_end == nullptr) line_end = text_end;
+        lineno++;
+        int fields = 0, value;
+        for (const char * p = line; scan_int(p, line_end, value); ) fields++;
+        if (fields > 0) {
+            const char * p = line;
+            scan_int(p, line_end, columns.pid[row]);
+            scan_int(p, line_end, columns.arrival[row]);
+            scan_int(p, line_end, columns.priority[row]);
+            if (columns.priority[row] < 1 || columns.priority[row] > 3) {
+                cerr << "Invalid process priority on workload line " << lineno << ".\n";
+                return false;
+            }
+            int count = fields - 3;
+            columns.cpu_begin[row] = columns.cpu_end[row] = offset;
+            columns.io_begin[row] = columns.io_end[row] = offset + (count + 1) / 2;
+            for (int j = 0; j < count; j++) {
+                scan_int(p, line_end, value);
+                if (value <= 0) {
+                    cerr << "Burst " << j + 1 << " of process " << columns.pid[row] << " on workload line " << lineno << " is not positive.\n";
+                    return false;
+                }
+                if (j%2) columns.bursts[columns.io_end[row]++] = value;
+                else columns.bursts[columns.cpu_end[row]++] = value;
+            }
+            offset += count;
+            row++;
+        }
+        line = line_end + 1;
+    }
+    return true;
+}
+
+///////////////////////////////////////////////////
+///// BINARY WORKLOAD FORMAT //////////////////////
+///////////////////////////////////////////////////
+
+// a binary workload file is this header followed by the int32 columns PID, ARRIVAL, PRIORITY,
+// CPU_BEGIN, CPU_END, IO_BEGIN, IO_END (count entries each) and BURSTS (burst_count entries),
+// in native byte order.  the columns are used straight out of a memory mapping, so replaying
+// a workload costs no parsing at all
+struct WorkloadHeader {
+    char magic[8]; // WORKLOAD_MAGIC
+    int32_t count;
+    int32_t reserved;
+    int64_t burst_count;
+};
+const char WORKLOAD_MAGIC[8] = {'O', 'S', 'P', 'S', 'W', 'L', '1', '\0'};
+
+bool save_workload_binary(const ProcessTable& procs, const string& path) {
+    ofstream out(path, ios::binary);
+    if (!out.is_open()) { cerr << "Error opening workload file " << path << ".\n"; return false; }
+    WorkloadHeader header;
+    memcpy(header.magic, WORKLOAD_MAGIC, sizeof(header.magic));
+    header.count = procs.count;
+    header.reserved = 0;
+    header.burst_count = procs.burst_count;
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    const int * columns[7] = {procs.PID, procs.ARRIVAL, procs.PRIORITY, procs.CPU_BEGIN, procs.CPU_END, procs.IO_BEGIN, procs.IO_END};
+    for (int c = 0; c < 7; c++) out.write(reinterpret_cast<const char *>(columns[c]), sizeof(int) * procs.count);
+    out.write(reinterpret_cast<const char *>(procs.BURSTS), sizeof(int) * procs.burst_count);
+    if (!out.good()) { cerr << "Error writing workload file " << path << ".\n"; return false; }
+    return true;
+}
+
+// a workload loaded from disk for replay.  binary files are memory-mapped and the table's
+// workload columns point into the mapping; anything else is parsed as the text format.
+// the table is read-only, so every run (on any thread) can share it and attach its own
+// per-run columns
+class WorkloadFile {
+    private:
+        void * BASE; // mapping of a binary file
+        size_t SIZE;
+        Arena TEXTARENA; // holds the columns of a parsed text file
+        ProcessTable TABLE;
+
+        bool map_binary(int fd, size_t size) {
+            BASE = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (BASE == MAP_FAILED) { BASE = nullptr; cerr << "Error mapping workload file.\n"; return false; }
+            SIZE = size;
+            const WorkloadHeader * header = static_cast<const WorkloadHeader *>(BASE);
+            // the offsets into the burst column are ints
+            if (header->burst_count > INT_MAX) { cerr << "Workload file has more than " << INT_MAX << " bursts.\n"; return false; }
+            if (header->count < 0 || header->burst_count < 0 ||
+                size != sizeof(WorkloadHeader) + sizeof(int) * (7 * static_cast<size_t>(header->count) + header->burst_count)) {
+                cerr << "Workload file is truncated or corrupt.\n";
+                return false;
+            }
+            const int * column = reinterpret_cast<const int *>(header + 1);
+            int n = header->count;
+            TABLE.count = n;
+            TABLE.burst_count = header->burst_count;
+            TABLE.PID = column;
+            TABLE.ARRIVAL = column + n;
+            TABLE.PRIORITY = column + 2 * n;
+            TABLE.CPU_BEGIN = column + 3 * n;
+            TABLE.CPU_END = column + 4 * n;
+            TABLE.IO_BEGIN = column + 5 * n;
+            TABLE.IO_END = column + 6 * n;
+            TABLE.BURSTS = column + 7 * n;
+            // the offsets are trusted by the engines, so check them once here: at least one cpu
+            // burst, and io bursts between them, with or without one after the last
+            for (int i = 0; i < n; i++) {
+                long long cpus = static_cast<long long>(TABLE.CPU_END[i]) - TABLE.CPU_BEGIN[i];
+                long long ios = static_cast<long long>(TABLE.IO_END[i]) - TABLE.IO_BEGIN[i];
+                if (TABLE.CPU_BEGIN[i] < 0 || TABLE.CPU_BEGIN[i] >= TABLE.CPU_END[i] || TABLE.CPU_END[i] > TABLE.burst_count ||
+                    TABLE.IO_BEGIN[i] < 0 || TABLE.IO_BEGIN[i] > TABLE.IO_END[i] || TABLE.IO_END[i] > TABLE.burst_count ||
+                    (ios != cpus - 1 && ios != cpus) || TABLE.PRIORITY[i] < 1 || TABLE.PRIORITY[i] > 3) {
+                    cerr << "Workload file has an invalid entry for process " << i << ".\n";
+                    return false;
+                }
+                for (int b = TABLE.CPU_BEGIN[i]; b < TABLE.CPU_END[i]; b++) {
+                    if (TABLE.BURSTS[b] > 0) continue;
+                    cerr << "Workload file has a burst that is not positive: cpu burst " << b - TABLE.CPU_BEGIN[i] + 1 << " of process " << i << ".\n";
+                    return false;
+                }
+                for (int b = TABLE.IO_BEGIN[i]; b < TABLE.IO_END[i]; b++) {
+                    if (TABLE.BURSTS[b] > 0) continue;
+                    cerr << "Workload file has a burst that is not positive: io burst " << b - TABLE.IO_BEGIN[i] + 1 << " of process " << i << ".\n";
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    public:
+        WorkloadFile() : BASE(nullptr), SIZE(0) {};
+        ~WorkloadFile() { if (BASE != nullptr) munmap(BASE, SIZE); }
+        WorkloadFile(const WorkloadFile&) = delete;
+        WorkloadFile& operator=(const WorkloadFile&) = delete;
+
+        bool open(const string& path) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) { cerr << "Error opening workload file " << path << ".\n"; return false; }
+            struct stat info;
+            if (fstat(fd, &info) != 0) { ::close(fd); cerr << "Error reading workload file " << path << ".\n"; return false; }
+            size_t size = info.st_size;
+            char magic[8] = {0};
+            bool binary = size >= sizeof(WorkloadHeader) && pread(fd, magic, sizeof(magic), 0) == sizeof(magic) &&
+                          memcmp(magic, WORKLOAD_MAGIC, sizeof(magic)) == 0;
+            bool ok;
+            if (binary) {
+                ok = map_binary(fd, size);
+            } else {
+                // text: read it in whole and parse it in place
+                char * text = TEXTARENA.alloc<char>(size);
+                ok = pread(fd, text, size, 0) == static_cast<ssize_t>(size) &&
+                     parse_workload_text(text, text + size, TABLE, TEXTARENA);
+                if (!ok) cerr << "Error loading text workload " << path << ".\n";
+            }
+            ::close(fd);
+            return ok;
+        }
+
+        const ProcessTable& table() const { return TABLE; }
+};